@@ -0,0 +1,272 @@
+#ifndef A_STAR_HPP
+#define A_STAR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "board.hpp"
+#include "ida_star.hpp"
+
+// `State` is what the heuristic needs to resume at the node.
+template <int Side, typename State> struct a_star_node {
+  board_t<Side> board;
+  uint32_t parent;
+  uint16_t g;
+  uint16_t h;
+  uint8_t zero_pos;
+  uint8_t move;
+  State state;
+  // open-list neighbours within the node's f bucket, UINT32_MAX at the ends
+  bool open = false;
+  uint32_t prev = UINT32_MAX;
+  uint32_t next = UINT32_MAX;
+};
+
+// Every node A* ever generated, in fixed-size blocks that never move, with
+// an open-addressing index from board to node for duplicate detection that
+// doubles as it fills. Index slots keep the high half of the board's hash
+// next to the id, so probing past other boards rarely touches their nodes.
+// Nodes (which carry the open list too) and index together stay within the
+// budget; nothing is freed until the search ends.
+template <int Side, typename State> class node_arena {
+public:
+  static constexpr uint32_t none = UINT32_MAX;
+
+  explicit node_arena(size_t megabytes) {
+    // a node plus up to four index slots (half full before doubling)
+    size_t bytes = megabytes << 20;
+    _capacity =
+        bytes / (sizeof(a_star_node<Side, State>) + 4 * sizeof(uint64_t));
+    _capacity = std::max<size_t>(1, std::min<size_t>(_capacity, none - 1));
+
+    _index.assign(block_size, empty);
+  }
+
+  bool full() const { return _size == _capacity; }
+
+  a_star_node<Side, State> &operator[](uint32_t id) {
+    return _blocks[id / block_size][id % block_size];
+  }
+
+  // Id of the node holding `board`, `none` if it was never added (the low
+  // half of an empty slot).
+  uint32_t find(const board_t<Side> &board) {
+    return uint32_t(_index[slot(board, board.key())]);
+  }
+
+  // Adds `node`, whose board must not be in the arena yet.
+  uint32_t add(const a_star_node<Side, State> &node) {
+    if (_size % block_size == 0) {
+      _blocks.emplace_back(new a_star_node<Side, State>[block_size]);
+    }
+    if (2 * (_size + 1) > _index.size()) {
+      grow();
+    }
+
+    (*this)[_size] = node;
+    enter(node.board.key(), _size);
+    return _size++;
+  }
+
+private:
+  static const size_t block_size = 1 << 16;
+  static constexpr uint64_t empty = UINT64_MAX;
+
+  std::vector<std::unique_ptr<a_star_node<Side, State>[]>> _blocks;
+  // tag (high half of the hash) << 32 | id
+  std::vector<uint64_t> _index;
+  size_t _size = 0;
+  size_t _capacity;
+
+  // Slot holding `board`, or the empty one where it would go.
+  size_t slot(const board_t<Side> &board, uint64_t key) {
+    size_t mask = _index.size() - 1;
+    size_t at = key & mask;
+    uint64_t tag = key >> 32;
+
+    for (; _index[at] != empty; at = (at + 1) & mask) {
+      if (_index[at] >> 32 == tag &&
+          (*this)[uint32_t(_index[at])].board == board) {
+        break;
+      }
+    }
+
+    return at;
+  }
+
+  void enter(uint64_t key, uint32_t id) {
+    size_t mask = _index.size() - 1;
+    size_t at = key & mask;
+
+    while (_index[at] != empty) {
+      at = (at + 1) & mask;
+    }
+    _index[at] = (key >> 32 << 32) | id;
+  }
+
+  void grow() {
+    _index.assign(2 * _index.size(), empty);
+
+    for (uint32_t id = 0; id < _size; id++) {
+      enter((*this)[id].board.key(), id);
+    }
+  }
+};
+
+// Open list with one bucket per f value. Buckets are stacks linked through
+// the nodes themselves, so the list takes no memory beyond the arena and
+// among equal f the most recent (usually deepest) node goes first.
+template <int Side, typename State> class bucket_queue {
+public:
+  static constexpr uint32_t none = node_arena<Side, State>::none;
+
+  explicit bucket_queue(node_arena<Side, State> &arena) : _arena(arena) {}
+
+  // Queues `id` under its current g + h; it must not be open.
+  void push(uint32_t id) {
+    a_star_node<Side, State> &node = _arena[id];
+    int f = node.g + node.h;
+
+    if (f >= int(_heads.size())) {
+      _heads.resize(f + 1, none);
+    }
+
+    node.open = true;
+    node.prev = none;
+    node.next = _heads[f];
+    if (node.next != none) {
+      _arena[node.next].prev = id;
+    }
+    _heads[f] = id;
+    _min = std::min(_min, f);
+  }
+
+  // Takes `id` off the list if it is open; done before its g changes.
+  void remove(uint32_t id) {
+    a_star_node<Side, State> &node = _arena[id];
+
+    if (!node.open) {
+      return;
+    }
+
+    if (node.prev != none) {
+      _arena[node.prev].next = node.next;
+    } else {
+      _heads[node.g + node.h] = node.next;
+    }
+    if (node.next != none) {
+      _arena[node.next].prev = node.prev;
+    }
+    node.open = false;
+  }
+
+  bool pop(uint32_t &id) {
+    while (_min < int(_heads.size()) && _heads[_min] == none) {
+      _min++;
+    }
+    if (_min == int(_heads.size())) {
+      return false;
+    }
+
+    id = _heads[_min];
+    remove(id);
+    return true;
+  }
+
+private:
+  node_arena<Side, State> &_arena;
+  // first node of every f bucket; f stays far below the node count
+  std::vector<uint32_t> _heads;
+  int _min = 0;
+};
+
+// A* over the whole state space within `megabytes` of nodes. Returns 1 with
+// the solution in `path`, 0 if there is none and -1 once the budget is
+// exhausted.
+template <int Side, typename Heuristic>
+int a_star(const std::vector<int> &board, std::vector<direction> &path,
+           search_stats &stats, Heuristic policy, size_t megabytes) {
+  using State = typename Heuristic::state;
+  using arena_t = node_arena<Side, State>;
+
+  arena_t arena(megabytes);
+  bucket_queue<Side, State> open(arena);
+  std::vector<int> cells;
+
+  int heuristic = policy.init(board);
+  a_star_node<Side, State> start = {board_t<Side>(board),
+                                    arena_t::none,
+                                    0,
+                                    uint16_t(heuristic),
+                                    uint8_t(find_zero_pos(board)),
+                                    direction::null,
+                                    policy.save()};
+
+  uint32_t id = arena.add(start);
+  open.push(id);
+  stats.iterations = 1;
+
+  while (open.pop(id)) {
+    a_star_node<Side, State> node = arena[id];
+
+    if (node.h == 0) {
+      path.resize(node.g);
+      for (uint32_t at = id; arena[at].parent != arena_t::none;
+           at = arena[at].parent) {
+        path[arena[at].g - 1] = direction(arena[at].move);
+      }
+      return 1;
+    }
+
+    stats.expanded++;
+    // the policy picks up where the node was saved, so every child is one
+    // update() away
+    unpack(node.board, cells);
+    policy.restore(cells, node.state);
+
+    for (direction dir : search_order) {
+      int tile_pos = moves<Side>.target[node.zero_pos][dir];
+
+      if (dir == opposite[node.move] || tile_pos < 0) {
+        continue;
+      }
+
+      int tile = node.board.get(tile_pos);
+      int h = policy.update(node.h, tile, tile_pos, node.zero_pos);
+      a_star_node<Side, State> child = {
+          node.board.slide(tile, tile_pos, node.zero_pos),
+          id,
+          uint16_t(node.g + 1),
+          uint16_t(h),
+          uint8_t(tile_pos),
+          uint8_t(dir),
+          policy.save()};
+      policy.revert(tile, tile_pos, node.zero_pos);
+
+      uint32_t seen = arena.find(child.board);
+
+      if (seen != arena_t::none) {
+        // (re)opened with the cheaper path
+        if (child.g < arena[seen].g) {
+          open.remove(seen);
+          arena[seen] = child;
+          open.push(seen);
+        }
+        continue;
+      }
+
+      if (arena.full()) {
+        return -1;
+      }
+
+      open.push(arena.add(child));
+    }
+  }
+
+  return 0;
+}
+
+#endif
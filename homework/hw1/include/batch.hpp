@@ -0,0 +1,30 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "solver.hpp"
+
+// Solves every puzzle in `in`, one per line ("//" lines and anything after
+// the board are ignored), on `threads` threads. Writes one "csv" or "json"
+// line per puzzle to `out` in input order and a summary with throughput and
+// latency percentiles to `summary`. Puzzles are read in chunks, so the input
+// can be arbitrarily long.
+void run_batch(std::istream &in, std::ostream &out, std::ostream &summary,
+               solver &s, const std::string &format, int threads);
+
+// Only parses and validates every puzzle in `in` (same format as above),
+// writing "index,error" for every invalid one to `out` and a summary with
+// the throughput to `summary`.
+void run_validation(std::istream &in, std::ostream &out,
+                    std::ostream &summary);
+
+// Solves every puzzle in `in` `repeat` times with `threads` search threads
+// and writes a CSV line per puzzle with the median wall time, its median
+// absolute deviation and nodes/s to `out`; totals go to `summary`.
+void run_benchmark(std::istream &in, std::ostream &out, std::ostream &summary,
+                   solver &s, int repeat, int threads);
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef BOARD_HPP
+#define BOARD_HPP
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Directions name the way the *tile* slides into the blank.
+enum direction { null, up, right, down, left };
+
+inline constexpr const char *direction_strings[] = {"null", "up", "right",
+                                                    "down", "left"};
+
+inline constexpr direction search_order[] = {direction::left, direction::right,
+                                             direction::down, direction::up};
+inline constexpr direction opposite[] = {direction::null, direction::down,
+                                         direction::left, direction::up,
+                                         direction::right};
+
+// Smallest and largest supported side; the search is instantiated per side.
+inline constexpr int min_board_side = 2;
+inline constexpr int max_board_side = 8;
+
+// For every blank cell and direction, the cell of the tile that slides into
+// the blank (which becomes the new blank), or -1 if there is none.
+template <int Side> struct move_table {
+  int8_t target[Side * Side][5];
+
+  constexpr move_table() : target() {
+    for (int cell = 0; cell < Side * Side; cell++) {
+      int y = cell / Side, x = cell % Side;
+
+      target[cell][direction::null] = -1;
+      target[cell][direction::up] = y < Side - 1 ? cell + Side : -1;
+      target[cell][direction::down] = y > 0 ? cell - Side : -1;
+      target[cell][direction::left] = x < Side - 1 ? cell + 1 : -1;
+      target[cell][direction::right] = x > 0 ? cell - 1 : -1;
+    }
+  }
+};
+
+template <int Side> inline constexpr move_table<Side> moves{};
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+// Finalizer of splitmix64, to spread board words over hash table slots.
+inline uint64_t mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+// Board packed into a single integer, one field per cell: 4-bit nibbles in a
+// 64-bit word up to 4x4, 5-bit fields in a 128-bit word for 5x5. It is small
+// enough to be passed by value and kept in registers through the search.
+template <int Side> class packed_board {
+public:
+  static constexpr int cells = Side * Side;
+  static constexpr int bits = cells <= 16 ? 4 : 5;
+  typedef std::conditional_t<cells <= 16, uint64_t, uint128_t> word;
+
+  static_assert(cells * bits <= int(sizeof(word) * 8), "board too large");
+
+  packed_board() = default;
+
+  explicit packed_board(const std::vector<int> &board) {
+    for (int i = 0; i < cells; i++) {
+      _word |= word(board[i]) << (i * bits);
+    }
+  }
+
+  int get(int cell) const {
+    return int(_word >> (cell * bits)) & ((1 << bits) - 1);
+  }
+
+  // Board after `tile` at `from` slid into the blank at `to`.
+  packed_board slide(int tile, int from, int to) const {
+    packed_board next;
+    next._word = _word - (word(tile) << (from * bits)) +
+                 (word(tile) << (to * bits));
+    return next;
+  }
+
+  word value() const { return _word; }
+
+  uint64_t key() const {
+    if constexpr (sizeof(word) > sizeof(uint64_t)) {
+      return mix(uint64_t(_word) ^ mix(uint64_t(_word >> 64)));
+    } else {
+      return mix(_word);
+    }
+  }
+
+  bool operator==(const packed_board &other) const {
+    return _word == other._word;
+  }
+
+private:
+  word _word = 0;
+};
+
+// One byte per cell for the boards that do not fit into 128 bits.
+template <int Side> class byte_board {
+public:
+  static constexpr int cells = Side * Side;
+
+  byte_board() = default;
+
+  explicit byte_board(const std::vector<int> &board) {
+    for (int i = 0; i < cells; i++) {
+      _cells[i] = board[i];
+    }
+  }
+
+  int get(int cell) const { return _cells[cell]; }
+
+  uint64_t key() const {
+    uint64_t hash = 0;
+    for (uint8_t cell : _cells) {
+      hash = mix(hash ^ cell);
+    }
+    return hash;
+  }
+
+  byte_board slide(int tile, int from, int to) const {
+    byte_board next = *this;
+    next._cells[to] = tile;
+    next._cells[from] = 0;
+    return next;
+  }
+
+  bool operator==(const byte_board &other) const {
+    return _cells == other._cells;
+  }
+
+private:
+  std::array<uint8_t, cells> _cells{};
+};
+
+template <int Side>
+using board_t = std::conditional_t<(Side <= 5), packed_board<Side>,
+                                   byte_board<Side>>;
+
+template <typename Board>
+void unpack(const Board &board, std::vector<int> &cells) {
+  cells.resize(Board::cells);
+  for (int i = 0; i < Board::cells; i++) {
+    cells[i] = board.get(i);
+  }
+}
+
+template <typename Board> std::vector<int> unpack(const Board &board) {
+  std::vector<int> cells;
+  unpack(board, cells);
+  return cells;
+}
+
+inline int find_zero_pos(const std::vector<int> &board) {
+  for (size_t i = 0; i < board.size(); i++) {
+    if (board[i] == 0) {
+      return i;
+    }
+  }
+
+  throw std::invalid_argument("No zero found");
+}
+
+#endif
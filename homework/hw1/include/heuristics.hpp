@@ -0,0 +1,373 @@
+#ifndef HEURISTICS_HPP
+#define HEURISTICS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+
+#include "pattern_database.hpp"
+#include "walking_distance.hpp"
+
+// Heuristic policies for the IDA* search. Each policy is a small value type
+// the search is instantiated with, so the per-node call is inlined:
+//
+//   int init(const std::vector<int> &board);
+//     full evaluation of `board` (tile per cell); resets internal state
+//   int update(int heuristic, int tile, int from, int to);
+//     value after `tile` slid from cell `from` into the blank at `to`
+//   void revert(int tile, int from, int to);
+//     undoes the matching update()
+//   state save() const;
+//   void restore(const std::vector<int> &board, const state &saved);
+//     what A* keeps in a node, and puts back when it expands the node, so
+//     that update() can go on from there without a full init()
+//
+// Policies are copied per search, shared tables are only referenced.
+
+inline int goal_position(int tile, int blank_goal) {
+  return tile - 1 + (tile > blank_goal);
+}
+
+class manhattan_heuristic {
+public:
+  manhattan_heuristic(int side, int blank_goal)
+      : _tiles(side * side), _distances(_tiles * _tiles, 0) {
+    for (int tile = 1; tile < _tiles; tile++) {
+      int goal = goal_position(tile, blank_goal);
+
+      for (int i = 0; i < _tiles; i++) {
+        _distances[tile * _tiles + i] =
+            abs(goal / side - i / side) + abs(goal % side - i % side);
+      }
+    }
+  }
+
+  int init(const std::vector<int> &board) {
+    int dist = 0;
+
+    for (int i = 0; i < _tiles; i++) {
+      dist += distance(board[i], i);
+    }
+
+    return dist;
+  }
+
+  int update(int heuristic, int tile, int from, int to) {
+    return heuristic - distance(tile, from) + distance(tile, to);
+  }
+
+  void revert(int, int, int) {}
+
+  // the heuristic value itself is all there is
+  struct state {};
+
+  state save() const { return {}; }
+
+  void restore(const std::vector<int> &, const state &) {}
+
+  int distance(int tile, int position) const {
+    return _distances[tile * _tiles + position];
+  }
+
+private:
+  int _tiles;
+  std::vector<int> _distances;
+};
+
+// Manhattan distance plus two moves for every tile that has to leave its goal
+// line to let the others pass. Only tiles in their goal line count, so a move
+// changes at most the one line the tile enters or leaves; its old count goes
+// on a stack for revert().
+class linear_conflict_heuristic {
+public:
+  linear_conflict_heuristic(int side, int blank_goal)
+      : _manhattan(side, blank_goal), _side(side), _goal_row(), _goal_column(),
+        _board(), _conflicts(), _history() {
+    if (side > max_side) {
+      throw std::invalid_argument(
+          "Linear conflict supports boards up to 8x8 only.");
+    }
+
+    for (int tile = 1; tile < side * side; tile++) {
+      int goal = goal_position(tile, blank_goal);
+      _goal_row[tile] = goal / side;
+      _goal_column[tile] = goal % side;
+    }
+  }
+
+  int init(const std::vector<int> &board) {
+    restore(board, {});
+
+    int conflicts = 0;
+    for (int line = 0; line < 2 * _side; line++) {
+      conflicts += _conflicts[line];
+    }
+
+    return _manhattan.init(board) + 2 * conflicts;
+  }
+
+  int update(int heuristic, int tile, int from, int to) {
+    heuristic = _manhattan.update(heuristic, tile, from, to);
+
+    _board[to] = tile;
+    _board[from] = 0;
+
+    int line = changed_line(tile, from, to);
+    if (line < 0) {
+      return heuristic;
+    }
+
+    int before = _conflicts[line];
+    _history.push_back(before);
+    _conflicts[line] =
+        line < _side ? row_conflicts(line) : column_conflicts(line - _side);
+
+    return heuristic + 2 * (_conflicts[line] - before);
+  }
+
+  void revert(int tile, int from, int to) {
+    _board[from] = tile;
+    _board[to] = 0;
+
+    int line = changed_line(tile, from, to);
+    if (line >= 0) {
+      _conflicts[line] = _history.back();
+      _history.pop_back();
+    }
+  }
+
+  // the lines are recounted from the board
+  struct state {};
+
+  state save() const { return {}; }
+
+  void restore(const std::vector<int> &board, const state &) {
+    std::copy(board.begin(), board.end(), _board.begin());
+
+    for (int line = 0; line < _side; line++) {
+      _conflicts[line] = row_conflicts(line);
+      _conflicts[_side + line] = column_conflicts(line);
+    }
+    _history.clear();
+  }
+
+private:
+  static const int max_side = 8;
+
+  manhattan_heuristic _manhattan;
+  int _side;
+  std::array<int, max_side * max_side> _goal_row;
+  std::array<int, max_side * max_side> _goal_column;
+  std::array<int, max_side * max_side> _board;
+  // rows, then columns
+  std::array<int, 2 * max_side> _conflicts;
+  std::vector<int> _history;
+
+  // The goal line of `tile` if the move from `from` to `to` takes it into or
+  // out of that line, -1 otherwise. Moving along a line keeps its order.
+  int changed_line(int tile, int from, int to) const {
+    if (from % _side == to % _side) {
+      int row = _goal_row[tile];
+      return row == from / _side || row == to / _side ? row : -1;
+    }
+
+    int column = _goal_column[tile];
+    return column == from % _side || column == to % _side ? _side + column
+                                                          : -1;
+  }
+
+  int row_conflicts(int row) const {
+    int goals[max_side], count = 0;
+
+    for (int x = 0; x < _side; x++) {
+      int tile = _board[row * _side + x];
+      if (tile && _goal_row[tile] == row) {
+        goals[count++] = _goal_column[tile];
+      }
+    }
+
+    return count - increasing(goals, count);
+  }
+
+  int column_conflicts(int column) const {
+    int goals[max_side], count = 0;
+
+    for (int y = 0; y < _side; y++) {
+      int tile = _board[y * _side + column];
+      if (tile && _goal_column[tile] == column) {
+        goals[count++] = _goal_row[tile];
+      }
+    }
+
+    return count - increasing(goals, count);
+  }
+
+  // Longest increasing subsequence; the rest of the line has to step aside.
+  static int increasing(const int *goals, int count) {
+    int longest[max_side], best = 0;
+
+    for (int i = 0; i < count; i++) {
+      longest[i] = 1;
+      for (int j = 0; j < i; j++) {
+        if (goals[j] < goals[i] && longest[j] + 1 > longest[i]) {
+          longest[i] = longest[j] + 1;
+        }
+      }
+      if (longest[i] > best) {
+        best = longest[i];
+      }
+    }
+
+    return best;
+  }
+};
+
+// Sum of the row and column walking distances. Vertical moves only change
+// the row state and horizontal ones only the column state.
+class walking_distance_heuristic {
+public:
+  walking_distance_heuristic(int side, int blank_goal,
+                             const walking_distance &rows,
+                             const walking_distance &columns)
+      : _side(side), _rows(&rows), _columns(&columns), _goal(side * side),
+        _history() {
+    for (int tile = 1; tile < side * side; tile++) {
+      _goal[tile] = goal_position(tile, blank_goal);
+    }
+  }
+
+  int init(const std::vector<int> &board) {
+    std::vector<int> row_counts(_side * _side, 0);
+    std::vector<int> column_counts(_side * _side, 0);
+    int blank = 0;
+
+    for (int i = 0; i < _side * _side; i++) {
+      if (!board[i]) {
+        blank = i;
+        continue;
+      }
+      int goal = _goal[board[i]];
+      row_counts[i / _side * _side + goal / _side]++;
+      column_counts[i % _side * _side + goal % _side]++;
+    }
+
+    _row = _rows->state(row_counts, blank / _side);
+    _column = _columns->state(column_counts, blank % _side);
+    _history.clear();
+
+    return _rows->distance(_row) + _columns->distance(_column);
+  }
+
+  int update(int, int tile, int from, int to) {
+    _history.push_back(_row);
+    _history.push_back(_column);
+
+    if (from % _side == to % _side) {
+      _row = _rows->next(_row, from > to, _goal[tile] / _side);
+    } else {
+      _column = _columns->next(_column, from > to, _goal[tile] % _side);
+    }
+
+    return _rows->distance(_row) + _columns->distance(_column);
+  }
+
+  void revert(int, int, int) {
+    _column = _history.back();
+    _history.pop_back();
+    _row = _history.back();
+    _history.pop_back();
+  }
+
+  // 4x4 tables have fewer than 2^16 states per axis
+  struct state {
+    uint16_t row;
+    uint16_t column;
+  };
+
+  state save() const { return {uint16_t(_row), uint16_t(_column)}; }
+
+  void restore(const std::vector<int> &, const state &saved) {
+    _row = saved.row;
+    _column = saved.column;
+    _history.clear();
+  }
+
+private:
+  int _side;
+  const walking_distance *_rows;
+  const walking_distance *_columns;
+  std::vector<int> _goal;
+  std::vector<int> _history;
+  int _row = 0;
+  int _column = 0;
+};
+
+// Manhattan distance plus the excess the pattern databases record for every
+// group; only the moved tile's group is looked up again.
+class pdb_heuristic {
+public:
+  pdb_heuristic(int side, int blank_goal, const pattern_database &pdb)
+      : _manhattan(side, blank_goal), _pdb(&pdb), _positions(side * side),
+        _extra(pdb.groups()), _history() {}
+
+  int init(const std::vector<int> &board) {
+    for (size_t i = 0; i < board.size(); i++) {
+      _positions[board[i]] = i;
+    }
+
+    int extra = 0;
+    for (int group = 0; group < _pdb->groups(); group++) {
+      _extra[group] = _pdb->extra(group, _positions.data());
+      extra += _extra[group];
+    }
+    _history.clear();
+
+    return _manhattan.init(board) + 2 * extra;
+  }
+
+  int update(int heuristic, int tile, int from, int to) {
+    int group = _pdb->group_of(tile);
+    int before = _extra[group];
+
+    _positions[tile] = to;
+    _extra[group] = _pdb->extra(group, _positions.data());
+    _history.push_back(before);
+
+    return _manhattan.update(heuristic, tile, from, to) +
+           2 * (_extra[group] - before);
+  }
+
+  void revert(int tile, int from, int) {
+    _positions[tile] = from;
+    _extra[_pdb->group_of(tile)] = _history.back();
+    _history.pop_back();
+  }
+
+  // positions come from the board, the group values from the tables
+  struct state {};
+
+  state save() const { return {}; }
+
+  void restore(const std::vector<int> &board, const state &) {
+    for (size_t i = 0; i < board.size(); i++) {
+      _positions[board[i]] = i;
+    }
+    for (int group = 0; group < _pdb->groups(); group++) {
+      _extra[group] = _pdb->extra(group, _positions.data());
+    }
+    _history.clear();
+  }
+
+private:
+  manhattan_heuristic _manhattan;
+  const pattern_database *_pdb;
+  std::vector<int> _positions;
+  std::vector<int> _extra;
+  std::vector<int> _history;
+};
+
+#endif
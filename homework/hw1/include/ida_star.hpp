@@ -0,0 +1,248 @@
+#ifndef IDA_STAR_HPP
+#define IDA_STAR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "board.hpp"
+#include "work_stealing.hpp"
+
+struct search_stats {
+  long long expanded = 0;
+  long long transpositions = 0;
+  int iterations = 0;
+  // time of an A* run that ran out of memory before IDA* took over; the
+  // counts above are IDA*'s alone
+  double abandoned_millis = 0;
+};
+
+// Returns -1 once a solution is found (leaving it in `path`), otherwise the
+// smallest cost over the bound. Gives up early, with a meaningless result,
+// once `stop` is set.
+template <int Side, typename Heuristic, typename Table>
+int id_search(board_t<Side> board, uint64_t hash, int zero_pos, int depth,
+              int heuristic, int bound, direction last_move,
+              std::vector<direction> &path, Heuristic &policy, Table &table,
+              search_stats &stats, const std::atomic<bool> &stop) {
+  if (heuristic == 0) {
+    path.resize(depth);
+    return -1;
+  }
+
+  int cost = depth + heuristic;
+
+  if (cost > bound) {
+    return cost;
+  }
+
+  if (stop.load(std::memory_order_relaxed)) {
+    return std::numeric_limits<int>::max();
+  }
+
+  // reached no later before, whatever lies below was already bounded
+  if (!table.visit(hash, depth)) {
+    stats.transpositions++;
+    return std::numeric_limits<int>::max();
+  }
+
+  stats.expanded++;
+
+  int min = std::numeric_limits<int>::max();
+
+  for (direction dir : search_order) {
+    int tile_pos = moves<Side>.target[zero_pos][dir];
+
+    if (dir == opposite[last_move] || tile_pos < 0) {
+      continue;
+    }
+
+    int tile = board.get(tile_pos);
+    int new_heuristic = policy.update(heuristic, tile, tile_pos, zero_pos);
+
+    path[depth] = dir;
+
+    int new_bound = id_search<Side>(
+        board.slide(tile, tile_pos, zero_pos),
+        table.move(hash, tile, tile_pos, zero_pos), tile_pos, depth + 1,
+        new_heuristic, bound, dir, path, policy, table, stats, stop);
+
+    if (new_bound == -1) {
+      return -1;
+    }
+
+    min = std::min(new_bound, min);
+
+    policy.revert(tile, tile_pos, zero_pos);
+  }
+
+  return min;
+}
+
+template <int Side, typename Heuristic, typename Table>
+int ida_star(const std::vector<int> &board, std::vector<direction> &path,
+             search_stats &stats, Heuristic policy, Table &table) {
+  std::atomic<bool> stop(false);
+  int zero_pos = find_zero_pos(board);
+  uint64_t hash = table.hash(board);
+
+  int heuristic = policy.init(board);
+  int bound = heuristic;
+
+  while (true) {
+    stats.iterations++;
+    table.next_iteration();
+
+    // every move costs one, so no path in this iteration is longer than bound
+    path.resize(bound + 1);
+
+    int new_bound = id_search<Side>(board_t<Side>(board), hash, zero_pos, 0,
+                                    heuristic, bound, direction::null, path,
+                                    policy, table, stats, stop);
+    if (new_bound == -1) {
+      return 1;
+    }
+    if (new_bound == std::numeric_limits<int>::max()) {
+      return 0;
+    }
+    bound = new_bound;
+  }
+}
+
+// Roughly how many subtrees every bound is split into for the workers.
+static const size_t parallel_frontier = 4096;
+
+template <int Side> struct frontier_node {
+  board_t<Side> board;
+  int zero_pos;
+  int heuristic;
+  std::vector<direction> path;
+};
+
+// IDA* where every bound iteration is split into subtrees at a shallow depth
+// that are searched on `threads` workers. The subtrees are listed in the
+// order the sequential search visits them, so the same bounds are tried and
+// the solution found has the same optimal length.
+template <int Side, typename Heuristic, typename Table>
+int parallel_ida_star(const std::vector<int> &board,
+                      std::vector<direction> &path, search_stats &stats,
+                      Heuristic policy, Table &table, int threads) {
+  int heuristic = policy.init(board);
+  int bound = heuristic;
+
+  if (heuristic == 0) {
+    path.clear();
+    return 1;
+  }
+
+  std::vector<Heuristic> policies(threads, policy);
+  std::vector<search_stats> worker_stats(threads);
+  std::vector<int> worker_min(threads);
+
+  while (true) {
+    stats.iterations++;
+    table.next_iteration();
+
+    std::vector<frontier_node<Side>> frontier = {
+        {board_t<Side>(board), find_zero_pos(board), heuristic, {}}};
+    int min = std::numeric_limits<int>::max();
+
+    // breadth-first keeps every level in depth-first order
+    while (!frontier.empty() && frontier.size() < parallel_frontier) {
+      std::vector<frontier_node<Side>> next;
+
+      for (frontier_node<Side> &node : frontier) {
+        int depth = node.path.size();
+
+        if (depth + node.heuristic > bound) {
+          min = std::min(min, depth + node.heuristic);
+          continue;
+        }
+
+        stats.expanded++;
+        policy.init(unpack(node.board));
+        direction last_move = depth ? node.path.back() : direction::null;
+
+        for (direction dir : search_order) {
+          int tile_pos = moves<Side>.target[node.zero_pos][dir];
+
+          if (dir == opposite[last_move] || tile_pos < 0) {
+            continue;
+          }
+
+          int tile = node.board.get(tile_pos);
+          frontier_node<Side> child = {
+              node.board.slide(tile, tile_pos, node.zero_pos), tile_pos,
+              policy.update(node.heuristic, tile, tile_pos, node.zero_pos),
+              node.path};
+          child.path.push_back(dir);
+          policy.revert(tile, tile_pos, node.zero_pos);
+
+          if (child.heuristic == 0) {
+            path = child.path;
+            return 1;
+          }
+
+          next.push_back(std::move(child));
+        }
+      }
+
+      frontier.swap(next);
+    }
+
+    std::atomic<bool> stop(false);
+    std::mutex found_lock;
+    bool found = false;
+
+    std::fill(worker_min.begin(), worker_min.end(), min);
+
+    parallel_for(threads, frontier.size(), [&](int worker, size_t index) {
+      frontier_node<Side> &node = frontier[index];
+      Heuristic &local = policies[worker];
+      std::vector<direction> local_path = node.path;
+      int depth = node.path.size();
+
+      std::vector<int> cells = unpack(node.board);
+
+      local.init(cells);
+      local_path.resize(std::max(bound + 1, depth + 1));
+
+      int result = id_search<Side>(
+          node.board, table.hash(cells), node.zero_pos, depth, node.heuristic,
+          bound, depth ? node.path.back() : direction::null, local_path,
+          local, table, worker_stats[worker], stop);
+
+      if (result == -1) {
+        std::lock_guard<std::mutex> guard(found_lock);
+        if (!found) {
+          found = true;
+          path = local_path;
+        }
+        stop = true;
+      } else {
+        worker_min[worker] = std::min(worker_min[worker], result);
+      }
+    });
+
+    for (search_stats &local : worker_stats) {
+      stats.expanded += local.expanded;
+      stats.transpositions += local.transpositions;
+      local = search_stats();
+    }
+
+    if (found) {
+      return 1;
+    }
+
+    bound = *std::min_element(worker_min.begin(), worker_min.end());
+
+    if (bound == std::numeric_limits<int>::max()) {
+      return 0;
+    }
+  }
+}
+
+#endif
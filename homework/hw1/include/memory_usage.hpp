@@ -0,0 +1,9 @@
+#ifndef MEMORY_USAGE_HPP
+#define MEMORY_USAGE_HPP
+
+#include <cstddef>
+
+// Peak resident set size of the process so far, in bytes (0 if unknown).
+size_t peak_rss();
+
+#endif
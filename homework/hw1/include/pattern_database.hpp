@@ -0,0 +1,95 @@
+#ifndef PATTERN_DATABASE_HPP
+#define PATTERN_DATABASE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Disjoint additive pattern databases for the sliding-tile puzzle.
+//
+// The tiles are split into groups and for every placement of a group's tiles
+// the database keeps the least number of moves of *that group's* tiles needed
+// to reach the goal, so the values of all groups can be summed. Since every
+// move changes the group's Manhattan distance by one, the stored value minus
+// that distance is always even; only half of the excess is kept, one nibble
+// per placement.
+class pattern_database {
+public:
+  // Loads the database for the given board from `dir`, generating and saving
+  // it first if no matching file exists. `blank_goal` is the goal index of
+  // the blank and `sizes` the number of tiles in each group.
+  pattern_database(int side, int blank_goal, const std::vector<int> &sizes,
+                   const std::string &dir = ".");
+  ~pattern_database();
+
+  pattern_database(const pattern_database &) = delete;
+  pattern_database &operator=(const pattern_database &) = delete;
+
+  // Default group sizes for the usual boards (4-4, 7-8, 6-6-6-6).
+  static std::vector<int> default_sizes(int side);
+  static std::vector<int> parse_sizes(const std::string &spec);
+
+  int groups() const { return _groups.size(); }
+  int group_of(int tile) const { return _group_of[tile]; }
+
+  // Half of the excess over Manhattan distance for `group`, where
+  // `positions` maps every tile to its current cell.
+  int extra(int group, const int *positions) const;
+
+  // Sum of extra() over all groups.
+  int extra(const int *positions) const;
+
+private:
+  struct group_table {
+    std::vector<int> tiles;
+    std::vector<uint64_t> multipliers;
+    uint64_t entries = 0;
+    const uint8_t *data = nullptr;
+  };
+
+  int _side;
+  int _cells;
+  int _blank_goal;
+  std::vector<group_table> _groups;
+  std::vector<int> _group_of;
+  std::vector<int> _goal;
+
+  void *_mapping = nullptr;
+  size_t _mapping_size = 0;
+
+  std::string file_name(const std::string &dir,
+                        const std::vector<int> &sizes) const;
+  bool load(const std::string &path);
+  void generate(const std::string &path);
+  void generate_group(const group_table &group, std::vector<uint8_t> &data);
+
+  uint64_t rank(const group_table &group, const int *cells) const;
+  void unrank(const group_table &group, uint64_t index, int *cells) const;
+  uint32_t region(uint32_t occupied, int cell) const;
+};
+
+inline int pattern_database::extra(int group, const int *positions) const {
+  const group_table &g = _groups[group];
+  uint64_t index = 0;
+  uint32_t used = 0;
+
+  for (size_t i = 0; i < g.tiles.size(); i++) {
+    int cell = positions[g.tiles[i]];
+    index += (cell - __builtin_popcount(used & ((1u << cell) - 1))) *
+             g.multipliers[i];
+    used |= 1u << cell;
+  }
+
+  return (g.data[index >> 1] >> ((index & 1) << 2)) & 0xF;
+}
+
+inline int pattern_database::extra(const int *positions) const {
+  int sum = 0;
+  for (int group = 0; group < groups(); group++) {
+    sum += extra(group, positions);
+  }
+  return sum;
+}
+
+#endif
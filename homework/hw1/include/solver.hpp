@@ -0,0 +1,73 @@
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "board.hpp"
+#include "ida_star.hpp"
+#include "pattern_database.hpp"
+#include "transposition_table.hpp"
+#include "walking_distance.hpp"
+
+struct puzzle {
+  std::vector<int> board;
+  // goal index of the blank
+  int offset_after = 0;
+};
+
+// Reads one puzzle ("N I tile...") from `in`. Returns false if the input
+// ends before a puzzle starts and throws std::invalid_argument if it is
+// malformed or not solvable. Any board size is accepted.
+bool read_puzzle(std::istream &in, puzzle &p);
+
+// Same for a puzzle on a single line, parsed without streams; returns false
+// if the line holds no number at all. Anything after the board is ignored.
+bool parse_puzzle(const std::string &line, puzzle &p);
+
+struct solver_options {
+  // "ida" or "astar"
+  std::string engine = "ida";
+  std::string heuristic = "manhattan";
+  std::string pdb_spec;
+  std::string pdb_dir = ".";
+  int threads = 1;
+  // transposition table budget per search, 0 for none
+  size_t tt_megabytes = 0;
+  replacement tt_policy = replacement::depth;
+  // node budget of the A* engine, which falls back to IDA* beyond it,
+  // split between the searches that run at once
+  size_t memory_megabytes = 1024;
+};
+
+// Solves puzzles of any supported size and blank position with one
+// heuristic, keeping the tables it needs for every board shape it has seen.
+class solver {
+public:
+  explicit solver(const solver_options &options);
+
+  static bool known_heuristic(const std::string &name);
+
+  // Builds (or maps) the tables needed for boards shaped like `p`. Not
+  // thread safe; solve() is, for prepared shapes.
+  void prepare(const puzzle &p);
+
+  // Returns 1 and the moves in `path` if a solution exists, 0 otherwise.
+  // `searches` is how many calls run side by side, each of them on
+  // `threads` threads; they share the A* memory budget.
+  int solve(const puzzle &p, std::vector<direction> &path,
+            search_stats &stats, int threads, int searches) const;
+
+  const solver_options &options() const { return _options; }
+
+private:
+  solver_options _options;
+  std::map<std::pair<int, int>, std::unique_ptr<pattern_database>> _pdbs;
+  std::map<std::pair<int, int>, std::unique_ptr<walking_distance>> _walking;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef TRANSPOSITION_TABLE_HPP
+#define TRANSPOSITION_TABLE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Transposition policies for the IDA* search, chosen at compile time like
+// the heuristics:
+//
+//   uint64_t hash(const std::vector<int> &board) const;
+//   uint64_t move(uint64_t hash, int tile, int from, int to) const;
+//     hash after `tile` slid from cell `from` into the blank at `to`
+//   bool visit(uint64_t hash, int depth);
+//     false if the state was already reached this iteration at no greater
+//     depth, so its subtree can be skipped; records the visit otherwise
+//   void next_iteration();
+
+// Keeps nothing; compiles away.
+struct no_transpositions {
+  uint64_t hash(const std::vector<int> &) const { return 0; }
+  uint64_t move(uint64_t, int, int, int) const { return 0; }
+  bool visit(uint64_t, int) { return true; }
+  void next_iteration() {}
+};
+
+enum class replacement { depth, clock };
+
+// Fixed-size table of the smallest depth every state was reached at in the
+// current iteration, keyed by a Zobrist hash. Entries are single 64-bit
+// words updated with relaxed atomics, so the parallel workers share one
+// table without locks; a lost race only costs a duplicate expansion.
+//
+// Buckets hold four entries. When a bucket is full, `depth` replacement
+// evicts the deepest entry (its subtree is the cheapest to redo) and
+// `clock` the first entry not hit since the hand last passed it.
+class transposition_table {
+public:
+  transposition_table(int cells, size_t megabytes, replacement policy);
+
+  static replacement parse_policy(const std::string &name);
+
+  uint64_t hash(const std::vector<int> &board) const {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < board.size(); i++) {
+      if (board[i]) {
+        hash ^= _keys[i * _cells + board[i]];
+      }
+    }
+    return hash;
+  }
+
+  uint64_t move(uint64_t hash, int tile, int from, int to) const {
+    return hash ^ _keys[from * _cells + tile] ^ _keys[to * _cells + tile];
+  }
+
+  bool visit(uint64_t hash, int depth);
+
+  void next_iteration();
+
+private:
+  // entry layout: key (46 bits) | stamp (8) | depth (9) | referenced (1);
+  // a stamp of 0 marks an empty entry
+  static const int bucket_size = 4;
+  static const int max_depth = (1 << 9) - 1;
+
+  int _cells;
+  replacement _policy;
+  std::vector<uint64_t> _keys;
+  std::unique_ptr<std::atomic<uint64_t>[]> _entries;
+  uint64_t _mask = 0;
+  uint64_t _stamp = 1;
+
+  static uint64_t pack(uint64_t key, uint64_t stamp, uint64_t depth) {
+    return key << 18 | stamp << 10 | depth << 1 | 1;
+  }
+  static uint64_t key_of(uint64_t entry) { return entry >> 18; }
+  static uint64_t stamp_of(uint64_t entry) { return entry >> 10 & 0xFF; }
+  static int depth_of(uint64_t entry) { return entry >> 1 & max_depth; }
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef VALIDATION_HPP
+#define VALIDATION_HPP
+
+#include <string>
+#include <vector>
+
+// Throws std::invalid_argument unless `board` holds every number from 0 to
+// its size - 1 exactly once. Linear, with a bitmap of the numbers seen.
+void validate_board(const std::vector<int> &board);
+
+// Number of pairs of tiles (ignoring the blank) out of order, counted with a
+// Fenwick tree in O(N log N). `board` must be valid.
+long long count_inversions(const std::vector<int> &board);
+
+// Whether `board` can reach the goal with the blank at `blank_goal`.
+bool is_solvable(const std::vector<int> &board, int blank_goal);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef WALKING_DISTANCE_HPP
+#define WALKING_DISTANCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Walking distance table for one axis of the board. A state counts, for every
+// line (row or column), how many of its tiles belong to each goal line, plus
+// the line holding the blank. The table keeps the number of moves along that
+// axis needed to reach the goal counts and the successor of every state, so
+// the search can follow a move with a single lookup.
+class walking_distance {
+public:
+  // `blank_line` is the goal row (or column) of the blank.
+  walking_distance(int side, int blank_line);
+
+  // State id for the given counts (`counts[line * side + goal_line]`).
+  int state(const std::vector<int> &counts, int blank) const;
+
+  int distance(int state) const { return _distances[state]; }
+
+  // State after the blank moves one line towards `forward` (up/left when
+  // false) swapping places with a tile whose goal line is `goal_line`.
+  int next(int state, bool forward, int goal_line) const {
+    return _next[(state * 2 + forward) * _side + goal_line];
+  }
+
+  size_t states() const { return _distances.size(); }
+
+private:
+  int _side;
+  std::unordered_map<uint64_t, int> _ids;
+  std::vector<uint8_t> _distances;
+  std::vector<int> _next;
+
+  uint64_t encode(const std::vector<int> &counts, int blank) const;
+  void decode(uint64_t key, std::vector<int> &counts, int &blank) const;
+};
+
+#endif
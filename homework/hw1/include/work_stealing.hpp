@@ -0,0 +1,97 @@
+#ifndef WORK_STEALING_HPP
+#define WORK_STEALING_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs `task(worker, index)` for every index in [0, count) on `threads`
+// threads and returns once all of them are done. Every worker starts with a
+// contiguous block of indices and takes them in order from the front; a
+// worker that runs dry steals the back half of another worker's block. The
+// first exception thrown by a task is rethrown here.
+template <typename Task>
+void parallel_for(int threads, size_t count, Task task) {
+  threads = std::max(1, std::min<int>(threads, count));
+
+  struct alignas(64) block {
+    std::mutex lock;
+    size_t begin = 0;
+    size_t end = 0;
+  };
+
+  std::vector<block> blocks(threads);
+  for (int i = 0; i < threads; i++) {
+    blocks[i].begin = count * i / threads;
+    blocks[i].end = count * (i + 1) / threads;
+  }
+
+  std::mutex error_lock;
+  std::exception_ptr error;
+
+  auto take = [&](int worker, size_t &index) {
+    {
+      std::lock_guard<std::mutex> guard(blocks[worker].lock);
+      if (blocks[worker].begin < blocks[worker].end) {
+        index = blocks[worker].begin++;
+        return true;
+      }
+    }
+
+    for (int i = 1; i < threads; i++) {
+      block &victim = blocks[(worker + i) % threads];
+      size_t begin, end;
+      {
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (victim.begin >= victim.end) {
+          continue;
+        }
+        begin = victim.begin + (victim.end - victim.begin) / 2;
+        end = victim.end;
+        victim.end = begin;
+      }
+
+      std::lock_guard<std::mutex> guard(blocks[worker].lock);
+      index = begin;
+      blocks[worker].begin = begin + 1;
+      blocks[worker].end = end;
+      return true;
+    }
+
+    // no work is ever added, so once every block is empty we are done
+    return false;
+  };
+
+  auto work = [&](int worker) {
+    size_t index;
+    while (take(worker, index)) {
+      try {
+        task(worker, index);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(error_lock);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int i = 1; i < threads; i++) {
+    pool.emplace_back(work, i);
+  }
+  work(0);
+
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+#endif
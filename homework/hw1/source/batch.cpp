@@ -0,0 +1,314 @@
+#include "batch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#include "memory_usage.hpp"
+#include "work_stealing.hpp"
+
+// How many puzzles are held in memory at once.
+static const size_t batch_chunk = 1024;
+
+struct batch_result {
+  size_t index = 0;
+  int tiles = 0;
+  int length = -1;
+  search_stats stats;
+  double millis = 0;
+  std::string error;
+};
+
+static std::string escape_json(const std::string &text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+// Quoted CSV field (RFC 4180): quotes are doubled, newlines may stay.
+static std::string escape_csv(const std::string &text) {
+  std::string escaped = "\"";
+  for (char c : text) {
+    if (c == '"') {
+      escaped += '"';
+    }
+    escaped += c;
+  }
+  return escaped + '"';
+}
+
+static void write_result(std::ostream &out, const batch_result &result,
+                         bool json) {
+  char line[512];
+
+  if (json) {
+    snprintf(line, sizeof(line),
+             "{\"index\":%zu,\"tiles\":%d,\"length\":%d,\"expanded\":%lld,"
+             "\"iterations\":%d,\"millis\":%.3f",
+             result.index, result.tiles, result.length, result.stats.expanded,
+             result.stats.iterations, result.millis);
+    out << line;
+    if (!result.error.empty()) {
+      out << ",\"error\":\"" << escape_json(result.error) << '"';
+    }
+    out << "}\n";
+  } else {
+    snprintf(line, sizeof(line), "%zu,%d,%d,%lld,%d,%.3f,", result.index,
+             result.tiles, result.length, result.stats.expanded,
+             result.stats.iterations, result.millis);
+    out << line << escape_csv(result.error) << '\n';
+  }
+}
+
+static bool skip_line(const std::string &line) {
+  return line.rfind("//", 0) == 0 ||
+         line.find_first_not_of(" \t\r") == std::string::npos;
+}
+
+static double median(std::vector<double> values) {
+  if (values.empty()) {
+    return 0;
+  }
+
+  size_t middle = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + middle, values.end());
+
+  if (values.size() & 1) {
+    return values[middle];
+  }
+  return (values[middle] +
+          *std::max_element(values.begin(), values.begin() + middle)) /
+         2;
+}
+
+// Nearest-rank percentile of sorted values.
+static double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t rank = std::ceil(p / 100 * sorted.size());
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+void run_batch(std::istream &in, std::ostream &out, std::ostream &summary,
+               solver &s, const std::string &format, int threads) {
+  if (format != "csv" && format != "json") {
+    throw std::invalid_argument("Unknown batch format " + format);
+  }
+  bool json = format == "json";
+
+  if (!json) {
+    out << "index,tiles,length,expanded,iterations,millis,error\n";
+  }
+
+  std::vector<double> latencies;
+  long long expanded = 0;
+  size_t solved = 0, failed = 0, index = 0;
+  std::string line;
+  bool more = true;
+
+  auto start = std::chrono::steady_clock::now();
+
+  while (more) {
+    std::vector<puzzle> puzzles;
+    std::vector<batch_result> results;
+
+    while (puzzles.size() < batch_chunk && (more = bool(getline(in, line)))) {
+      if (skip_line(line)) {
+        continue;
+      }
+
+      batch_result result;
+      puzzle p;
+
+      result.index = index++;
+
+      try {
+        if (!parse_puzzle(line, p)) {
+          throw std::invalid_argument("Invalid number of tiles.");
+        }
+        s.prepare(p);
+        result.tiles = p.board.size();
+      } catch (std::exception &e) {
+        result.error = e.what();
+        p.board.clear();
+      }
+
+      puzzles.push_back(std::move(p));
+      results.push_back(std::move(result));
+    }
+
+    // every puzzle is searched on one thread, the pool runs many of them
+    parallel_for(threads, puzzles.size(), [&](int, size_t i) {
+      if (puzzles[i].board.empty()) {
+        return;
+      }
+
+      std::vector<direction> path;
+      auto begin = std::chrono::steady_clock::now();
+
+      if (s.solve(puzzles[i], path, results[i].stats, 1, threads)) {
+        results[i].length = path.size();
+      } else {
+        results[i].error = "No solution found";
+      }
+
+      results[i].millis = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - begin)
+                              .count();
+    });
+
+    for (batch_result &result : results) {
+      write_result(out, result, json);
+
+      if (result.length >= 0) {
+        solved++;
+        latencies.push_back(result.millis);
+      } else {
+        failed++;
+      }
+      expanded += result.stats.expanded;
+    }
+    out.flush();
+  }
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::sort(latencies.begin(), latencies.end());
+
+  char text[512];
+  snprintf(text, sizeof(text),
+           "instances: %zu\nsolved: %zu\nfailed: %zu\ntime: %.2f\n"
+           "instances/s: %.2f\nnodes/s: %.0f\n"
+           "latency ms p50: %.3f p90: %.3f p99: %.3f max: %.3f\n"
+           "peak rss: %.1f MB\n",
+           solved + failed, solved, failed, seconds,
+           seconds > 0 ? solved / seconds : 0.,
+           seconds > 0 ? expanded / seconds : 0., percentile(latencies, 50),
+           percentile(latencies, 90), percentile(latencies, 99),
+           latencies.empty() ? 0. : latencies.back(),
+           peak_rss() / 1048576.);
+  summary << text;
+}
+
+void run_validation(std::istream &in, std::ostream &out,
+                    std::ostream &summary) {
+  size_t boards = 0, invalid = 0, bytes = 0;
+  std::string line;
+  puzzle p;
+
+  auto start = std::chrono::steady_clock::now();
+
+  while (getline(in, line)) {
+    bytes += line.size() + 1;
+
+    if (skip_line(line)) {
+      continue;
+    }
+
+    try {
+      if (!parse_puzzle(line, p)) {
+        throw std::invalid_argument("Invalid number of tiles.");
+      }
+    } catch (std::exception &e) {
+      out << boards << ',' << escape_csv(e.what()) << '\n';
+      invalid++;
+    }
+    boards++;
+  }
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  char text[256];
+  snprintf(text, sizeof(text),
+           "boards: %zu\nvalid: %zu\ninvalid: %zu\ntime: %.2f\n"
+           "boards/s: %.0f\nMB/s: %.1f\n",
+           boards, boards - invalid, invalid, seconds,
+           seconds > 0 ? boards / seconds : 0.,
+           seconds > 0 ? bytes / seconds / 1048576. : 0.);
+  summary << text;
+}
+
+void run_benchmark(std::istream &in, std::ostream &out, std::ostream &summary,
+                   solver &s, int repeat, int threads) {
+  out << "index,tiles,length,expanded,median_ms,mad_ms,nodes/s\n";
+
+  std::vector<double> rates;
+  double total_millis = 0, total_searching = 0;
+  long long total_expanded = 0;
+  size_t index = 0;
+  std::string line;
+  puzzle p;
+
+  while (getline(in, line)) {
+    if (skip_line(line)) {
+      continue;
+    }
+
+    if (!parse_puzzle(line, p)) {
+      throw std::invalid_argument("Invalid number of tiles.");
+    }
+    s.prepare(p);
+
+    // `searching` leaves out A* runs that ran out of memory, whose nodes are
+    // not counted
+    std::vector<double> millis, searching;
+    std::vector<direction> path;
+    search_stats stats;
+
+    for (int run = 0; run < repeat; run++) {
+      stats = search_stats();
+      path.clear();
+
+      auto begin = std::chrono::steady_clock::now();
+      s.solve(p, path, stats, threads, 1);
+      millis.push_back(std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - begin)
+                           .count());
+      searching.push_back(millis.back() - stats.abandoned_millis);
+    }
+
+    double mid = median(millis), mid_searching = median(searching);
+    std::vector<double> deviations;
+    for (double m : millis) {
+      deviations.push_back(std::abs(m - mid));
+    }
+
+    double rate =
+        mid_searching > 0 ? stats.expanded / (mid_searching / 1e3) : 0.;
+    rates.push_back(rate);
+    total_millis += mid;
+    total_searching += mid_searching;
+    total_expanded += stats.expanded;
+
+    char text[256];
+    snprintf(text, sizeof(text), "%zu,%zu,%zu,%lld,%.3f,%.3f,%.0f\n",
+             index++, p.board.size(), path.size(), stats.expanded, mid,
+             median(deviations), rate);
+    out << text;
+    out.flush();
+  }
+
+  char text[256];
+  snprintf(text, sizeof(text),
+           "instances: %zu\nruns: %d\nexpanded: %lld\n"
+           "time (sum of medians): %.3f\nnodes/s: %.0f\n"
+           "median nodes/s: %.0f\n",
+           index, repeat, total_expanded, total_millis / 1e3,
+           total_searching > 0 ? total_expanded / (total_searching / 1e3)
+                               : 0.,
+           median(rates));
+  summary << text;
+}
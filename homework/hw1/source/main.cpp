@@ -1,292 +1,135 @@
 #include <algorithm>
 #include <chrono>
-#include <cmath>
 #include <cstdio>
-#include <ctime>
 #include <exception>
+#include <fstream>
 #include <iostream>
-#include <istream>
-#include <limits>
-#include <queue>
-#include <set>
 #include <stdexcept>
+#include <string>
+#include <thread>
 
-typedef std::pair<int, int> coords;
+#include "batch.hpp"
+#include "memory_usage.hpp"
+#include "solver.hpp"
 
-enum direction { null, up, right, down, left };
-static const char *direction_strings[] = {"null", "up", "right", "down",
-                                          "left"};
-
-bool move(std::vector<int> &board, direction move, int &zero_pos, int &side) {
-
-  int zero_y = zero_pos / side;
-  int zero_x = zero_pos % side;
-
-  switch (move) {
-  case up:
-    if (zero_y >= side - 1) {
-      return false;
-    }
-    std::swap(board[zero_pos], board[zero_pos + side]);
-    zero_pos += side;
-    break;
-  case down:
-    if (zero_y <= 0) {
-      return false;
-    }
-    std::swap(board[zero_pos], board[zero_pos - side]);
-    zero_pos -= side;
-    break;
-  case left:
-    if (zero_x >= side - 1) {
-      return false;
-    }
-    std::swap(board[zero_pos], board[zero_pos + 1]);
-    zero_pos += 1;
-    break;
-  case right:
-    if (zero_x <= 0) {
-      return false;
-    }
-    std::swap(board[zero_pos], board[zero_pos - 1]);
-    zero_pos -= 1;
-    break;
-  default:
-    break;
-  }
-  return true;
-}
-
-int manhattan(std::vector<int> &board, int &offset_after) {
-  int dist = 0;
-  int side = sqrt(board.size());
-
-  for (size_t i = 0; i < board.size(); i++) {
-    if (board[i] == 0) {
-      continue;
-    }
-
-    bool offset = board[i] > offset_after;
-    int j = (board[i] - 1 + offset);
-
-    int x = j / side;
-    int y = j % side;
-    int x1 = i / side;
-    int y1 = i % side;
-
-    dist += abs(x - x1) + abs(y - y1);
-  }
-
-  return dist;
-}
-
-bool is_solvable(std::vector<int> &board) {
-  int inversions = 0;
-  int side = sqrt(board.size());
-  int blank = board.size() - 1;
+int main(int argc, char *argv[]) {
+  std::string batch_file;
+  bool validate_only = false;
+  std::string bench_file;
+  int repeat = 5;
 
-  for (size_t i = 0; i < board.size(); i++) {
-    if (board[i] == 0) {
-      blank = i;
-    }
-    for (size_t j = i + 1; j < board.size(); j++) {
-      if (board[i] != 0 && board[j] != 0 && board[i] > board[j]) {
-        inversions++;
+  try {
+    solver_options options;
+    std::string format = "csv";
+
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+
+      if (arg.rfind("--engine=", 0) == 0) {
+        options.engine = arg.substr(9);
+      } else if (arg.rfind("--memory=", 0) == 0) {
+        // megabytes
+        options.memory_megabytes = std::stoul(arg.substr(9));
+      } else if (arg.rfind("--heuristic=", 0) == 0) {
+        options.heuristic = arg.substr(12);
+      } else if (arg == "--pdb") {
+        options.heuristic = "pdb";
+      } else if (arg.rfind("--pdb=", 0) == 0) {
+        options.heuristic = "pdb";
+        options.pdb_spec = arg.substr(6);
+      } else if (arg.rfind("--pdb-dir=", 0) == 0) {
+        options.pdb_dir = arg.substr(10);
+      } else if (arg.rfind("--threads=", 0) == 0) {
+        // 0 uses every hardware thread
+        options.threads = std::stoi(arg.substr(10));
+        if (options.threads < 0) {
+          throw std::invalid_argument("Invalid thread count.");
+        }
+        if (options.threads == 0) {
+          options.threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+      } else if (arg.rfind("--tt=", 0) == 0) {
+        // megabytes
+        options.tt_megabytes = std::stoul(arg.substr(5));
+      } else if (arg.rfind("--tt-replace=", 0) == 0) {
+        options.tt_policy = transposition_table::parse_policy(arg.substr(13));
+      } else if (arg.rfind("--batch=", 0) == 0) {
+        batch_file = arg.substr(8);
+      } else if (arg.rfind("--bench=", 0) == 0) {
+        bench_file = arg.substr(8);
+      } else if (arg.rfind("--repeat=", 0) == 0) {
+        repeat = std::stoi(arg.substr(9));
+        if (repeat < 1) {
+          throw std::invalid_argument("Invalid repeat count.");
+        }
+      } else if (arg == "--validate-only") {
+        validate_only = true;
+      } else if (arg.rfind("--format=", 0) == 0) {
+        format = arg.substr(9);
+      } else {
+        throw std::invalid_argument("Unknown option " + arg);
       }
     }
-  }
-
-  if (side & 1 || !((blank / side + 1) & 1)) {
-    return !(inversions & 1);
-  }
-
-  return inversions & 1;
-}
-
-int find_zero_pos(std::vector<int> &board) {
-  for (size_t i = 0; i < board.size(); i++) {
-    if (board[i] == 0) {
-      return i;
-    }
-  }
-
-  throw std::invalid_argument("No zero found");
-}
-
-int id_search(std::vector<int> &board, std::deque<direction> &path,
-              int &zero_pos, int depth, int &bound, int &side,
-              int &offset_after) {
-  direction last_move = path.back();
-
-  int heuristic = manhattan(board, offset_after);
-
-  if (heuristic == 0) {
-    return -1;
-  }
-
-  int cost = depth + heuristic;
-
-  if (cost > bound) {
-    return cost;
-  }
-
-  int min = std::numeric_limits<int>::max();
-
-  if (last_move != direction::right &&
-      move(board, direction::left, zero_pos, side)) {
-    path.push_back(direction::left);
-
-    int new_bound =
-        id_search(board, path, zero_pos, depth + 1, bound, side, offset_after);
-
-    if (new_bound == -1) {
-      return -1;
-    }
-
-    min = std::min(new_bound, min);
-    path.pop_back();
-
-    move(board, direction::right, zero_pos, side);
-  }
-
-  if (last_move != direction::left &&
-      move(board, direction::right, zero_pos, side)) {
-    path.push_back(direction::right);
-
-    int new_bound =
-        id_search(board, path, zero_pos, depth + 1, bound, side, offset_after);
-
-    if (new_bound == -1) {
-      return -1;
-    }
-
-    min = std::min(new_bound, min);
-    path.pop_back();
-
-    move(board, direction::left, zero_pos, side);
-  }
 
-  if (last_move != direction::up &&
-      move(board, direction::down, zero_pos, side)) {
-    path.push_back(direction::down);
+    solver s(options);
 
-    int new_bound =
-        id_search(board, path, zero_pos, depth + 1, bound, side, offset_after);
+    if (!bench_file.empty()) {
+      std::ifstream file(bench_file);
+      if (!file) {
+        throw std::runtime_error("Could not open " + bench_file);
+      }
 
-    if (new_bound == -1) {
-      return -1;
+      run_benchmark(file, std::cout, std::cerr, s, repeat, options.threads);
+      return 0;
     }
-    min = std::min(new_bound, min);
-    path.pop_back();
-
-    move(board, direction::up, zero_pos, side);
-  }
-
-  if (last_move != direction::down &&
-      move(board, direction::up, zero_pos, side)) {
-    path.push_back(direction::up);
 
-    int new_bound =
-        id_search(board, path, zero_pos, depth + 1, bound, side, offset_after);
-
-    if (new_bound == -1) {
-      return -1;
+    if (validate_only && batch_file.empty()) {
+      batch_file = "-";
     }
-    min = std::min(new_bound, min);
-    path.pop_back();
-
-    move(board, direction::down, zero_pos, side);
-  }
-
-  return min;
-}
-
-int ida_star(std::vector<int> &board, int offset_after,
-             std::deque<direction> &path) {
-  int side = sqrt(board.size());
-  int zero_pos = find_zero_pos(board);
 
-  path.push_back(direction::null);
+    if (!batch_file.empty()) {
+      // "-" reads the puzzles from stdin
+      std::ifstream file;
+      if (batch_file != "-") {
+        file.open(batch_file);
+        if (!file) {
+          throw std::runtime_error("Could not open " + batch_file);
+        }
+      } else {
+        std::ios::sync_with_stdio(false);
+      }
 
-  int bound = manhattan(board, offset_after);
+      std::istream &in = batch_file == "-" ? std::cin : file;
 
-  while (true) {
-    int new_bound =
-        id_search(board, path, zero_pos, 0, bound, side, offset_after);
-    if (new_bound == -1) {
-      return 1;
-    }
-    if (new_bound == std::numeric_limits<int>::max()) {
+      if (validate_only) {
+        run_validation(in, std::cout, std::cerr);
+      } else {
+        run_batch(in, std::cout, std::cerr, s, format, options.threads);
+      }
       return 0;
     }
-    bound = new_bound;
-  }
-}
 
-int main(int argc, char *argv[]) {
-  try {
-    (void)argc;
-    (void)argv;
-
-    int numbers, empty_tile;
-    std::vector<int> board;
+    puzzle p;
 
-    std::cin >> numbers;
-
-    int tiles = numbers + 1;
-    int side = sqrt(tiles);
-
-    if (side * side != tiles) {
+    if (!read_puzzle(std::cin, p)) {
       throw std::invalid_argument("Invalid number of tiles.");
     }
 
-    std::cin >> empty_tile;
-
-    if ((empty_tile != -1 && (empty_tile > numbers || empty_tile < 1))) {
-      char s[255];
-      snprintf(s, 255,
-               "Invalid zero position. Valid are numbers in range 1 to %d "
-               "inclusive or -1 for default (%d).",
-               tiles, tiles);
-      throw std::invalid_argument(s);
-    }
-
-    board = std::vector<int>(tiles);
+    // tables are built (or mapped) before the clock starts
+    s.prepare(p);
 
-    int offset_after = empty_tile != -1 ? empty_tile - 1 : numbers;
-    std::set<int> check_set;
+    std::vector<direction> path;
+    search_stats stats;
 
-    for (int i = 0; i < tiles; i++) {
-      std::cin >> std::ws;
-      std::cin >> board[i];
-      check_set.insert(board[i]);
-    }
+    auto start = std::chrono::steady_clock::now();
 
-    if (check_set.size() != (size_t)tiles) {
-      throw std::invalid_argument("Invalid board (dupicate numbers)");
-    }
-    for (int n : check_set) {
-      if (n < 0 || n >= tiles) {
-        throw std::invalid_argument("Invalid board (invalid numbers)");
-      }
-    }
+    int result = s.solve(p, path, stats, options.threads, 1);
 
-    if (!is_solvable(board)) {
-      throw std::invalid_argument("Not solvable.");
-    }
-
-    std::deque<direction> path;
-
-    auto start = std::chrono::system_clock::now();
-
-    int result = ida_star(board, offset_after, path);
-
-    double total_millis = std::chrono::duration_cast<std::chrono::milliseconds>(
-                              std::chrono::system_clock::now() - start)
+    double total_millis = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - start)
                               .count();
 
     if (result) {
-      path.pop_front();
       std::cout << std::endl << path.size() << std::endl;
       for (auto dir : path) {
         std::cout << direction_strings[dir] << std::endl;
@@ -295,10 +138,28 @@ int main(int argc, char *argv[]) {
       std::cout << "No solution found" << std::endl;
     }
 
-    printf("\ntime: %.2f\n\n", total_millis / 1e3);
+    // the rate is IDA*'s alone after an A* run ran out of memory
+    double search_millis = total_millis - stats.abandoned_millis;
+
+    printf("\ntime: %.2f\n", total_millis / 1e3);
+    if (stats.abandoned_millis > 0) {
+      printf("abandoned a*: %.2f\n", stats.abandoned_millis / 1e3);
+    }
+    printf("expanded: %lld\n", stats.expanded);
+    printf("nodes/s: %.0f\n",
+           search_millis > 0 ? stats.expanded / (search_millis / 1e3) : 0.);
+    if (options.tt_megabytes) {
+      printf("transpositions: %lld\n", stats.transpositions);
+    }
+    printf("peak rss: %.1f MB\n", peak_rss() / 1048576.);
+    printf("\n");
 
   } catch (std::exception &e) {
     std::cout << e.what() << std::endl;
+
+    if (!batch_file.empty() || !bench_file.empty()) {
+      return 1;
+    }
   }
 
   int a = system("pause");
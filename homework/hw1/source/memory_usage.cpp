@@ -0,0 +1,32 @@
+#include "memory_usage.hpp"
+
+#ifdef _WIN32
+// resolves to K32GetProcessMemoryInfo, so psapi does not have to be linked
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+size_t peak_rss() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                           sizeof(counters))) {
+    return counters.PeakWorkingSetSize;
+  }
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return usage.ru_maxrss;
+#else
+  // kilobytes on Linux
+  return size_t(usage.ru_maxrss) << 10;
+#endif
+#endif
+}
@@ -0,0 +1,418 @@
+#include "pattern_database.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char magic[4] = {'P', 'D', 'B', '1'};
+
+pattern_database::pattern_database(int side, int blank_goal,
+                                   const std::vector<int> &sizes,
+                                   const std::string &dir)
+    : _side(side), _cells(side * side), _blank_goal(blank_goal) {
+  if (_cells > 32) {
+    throw std::invalid_argument(
+        "Pattern databases support boards up to 5x5 only.");
+  }
+
+  int total = 0;
+  for (int size : sizes) {
+    if (size < 1) {
+      throw std::invalid_argument("Invalid pattern database group size.");
+    }
+    total += size;
+  }
+  if (total != _cells - 1) {
+    throw std::invalid_argument(
+        "Pattern database groups must cover every tile exactly once.");
+  }
+
+  _goal = std::vector<int>(_cells);
+  _group_of = std::vector<int>(_cells, -1);
+
+  for (int tile = 1; tile < _cells; tile++) {
+    _goal[tile] = tile - 1 + (tile > _blank_goal);
+  }
+  _goal[0] = _blank_goal;
+
+  int tile = 1;
+  for (int size : sizes) {
+    group_table group;
+
+    for (int i = 0; i < size; i++, tile++) {
+      _group_of[tile] = _groups.size();
+      group.tiles.push_back(tile);
+    }
+
+    group.multipliers = std::vector<uint64_t>(size, 1);
+    for (int i = size - 2; i >= 0; i--) {
+      group.multipliers[i] = group.multipliers[i + 1] * (_cells - i - 1);
+    }
+    group.entries = group.multipliers[0] * _cells;
+
+    _groups.push_back(group);
+  }
+
+  std::string path = file_name(dir, sizes);
+
+  if (!load(path)) {
+    generate(path);
+
+    if (!load(path)) {
+      throw std::runtime_error("Could not map pattern database " + path);
+    }
+  }
+}
+
+pattern_database::~pattern_database() {
+  if (!_mapping) {
+    return;
+  }
+#ifdef _WIN32
+  UnmapViewOfFile(_mapping);
+#else
+  munmap(_mapping, _mapping_size);
+#endif
+}
+
+std::vector<int> pattern_database::default_sizes(int side) {
+  switch (side) {
+  case 3:
+    return {4, 4};
+  case 4:
+    return {7, 8};
+  case 5:
+    return {6, 6, 6, 6};
+  default:
+    throw std::invalid_argument(
+        "No default pattern database partition for this board size.");
+  }
+}
+
+std::vector<int> pattern_database::parse_sizes(const std::string &spec) {
+  std::vector<int> sizes;
+  std::stringstream ss(spec);
+  std::string part;
+
+  while (std::getline(ss, part, '-')) {
+    char *end = nullptr;
+    long size = strtol(part.c_str(), &end, 10);
+
+    if (part.empty() || *end != '\0' || size < 1) {
+      throw std::invalid_argument("Invalid pattern database partition: " +
+                                  spec);
+    }
+    sizes.push_back(size);
+  }
+
+  return sizes;
+}
+
+std::string pattern_database::file_name(const std::string &dir,
+                                        const std::vector<int> &sizes) const {
+  std::string name = dir + "/pdb-" + std::to_string(_cells - 1) + "-blank" +
+                     std::to_string(_blank_goal);
+
+  for (int size : sizes) {
+    name += "-" + std::to_string(size);
+  }
+
+  return name + ".bin";
+}
+
+bool pattern_database::load(const std::string &path) {
+  size_t size = 0;
+  void *base = nullptr;
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  HANDLE mapping = NULL;
+
+  if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+    size = file_size.QuadPart;
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  }
+  if (mapping) {
+    base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+  }
+  CloseHandle(file);
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    size = st.st_size;
+    base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+      base = nullptr;
+    }
+  }
+  close(fd);
+#endif
+
+  if (!base) {
+    return false;
+  }
+
+  // header: magic, side, blank goal, group count, group sizes
+  const uint8_t *bytes = static_cast<const uint8_t *>(base);
+  size_t header = sizeof(magic) + (3 + _groups.size()) * sizeof(int32_t);
+  bool valid = size >= header && memcmp(bytes, magic, sizeof(magic)) == 0;
+
+  if (valid) {
+    int32_t fields[3];
+    memcpy(fields, bytes + sizeof(magic), sizeof(fields));
+
+    valid = fields[0] == _side && fields[1] == _blank_goal &&
+            fields[2] == (int32_t)_groups.size();
+  }
+
+  size_t offset = header;
+  for (size_t i = 0; valid && i < _groups.size(); i++) {
+    int32_t group_size;
+    memcpy(&group_size, bytes + sizeof(magic) + (3 + i) * sizeof(int32_t),
+           sizeof(group_size));
+
+    valid = group_size == (int32_t)_groups[i].tiles.size();
+    _groups[i].data = bytes + offset;
+    offset += (_groups[i].entries + 1) / 2;
+  }
+
+  if (!valid || offset != size) {
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+#else
+    munmap(base, size);
+#endif
+    return false;
+  }
+
+  _mapping = base;
+  _mapping_size = size;
+
+  return true;
+}
+
+void pattern_database::generate(const std::string &path) {
+  // written aside and renamed, so an interrupted run leaves no partial file
+  std::string partial = path + ".partial";
+  std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+
+  if (!out.is_open()) {
+    throw std::runtime_error("Could not create pattern database " + partial);
+  }
+
+  int32_t fields[3] = {_side, _blank_goal, (int32_t)_groups.size()};
+
+  out.write(magic, sizeof(magic));
+  out.write(reinterpret_cast<const char *>(fields), sizeof(fields));
+
+  for (auto &group : _groups) {
+    int32_t group_size = group.tiles.size();
+    out.write(reinterpret_cast<const char *>(&group_size), sizeof(group_size));
+  }
+
+  for (size_t i = 0; i < _groups.size(); i++) {
+    std::cerr << "generating pattern database group " << i + 1 << '/'
+              << _groups.size() << " (" << _groups[i].entries
+              << " entries)..." << std::endl;
+
+    std::vector<uint8_t> data;
+    generate_group(_groups[i], data);
+
+    out.write(reinterpret_cast<const char *>(data.data()), data.size());
+  }
+
+  out.close();
+
+  if (!out) {
+    throw std::runtime_error("Could not write pattern database " + partial);
+  }
+
+  std::remove(path.c_str());
+
+  if (std::rename(partial.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Could not rename pattern database " + partial);
+  }
+}
+
+// Breadth-first search backwards from the goal placement. Moves of tiles
+// outside the group are free, so a search state is a placement together with
+// the region of free cells the blank can wander in, named by its lowest cell.
+void pattern_database::generate_group(const group_table &group,
+                                      std::vector<uint8_t> &data) {
+  const int k = group.tiles.size();
+
+  std::vector<uint64_t> visited((group.entries * _cells + 63) / 64, 0);
+  std::vector<uint64_t> seen((group.entries + 63) / 64, 0);
+  data = std::vector<uint8_t>((group.entries + 1) / 2, 0);
+
+  auto visit = [&](uint64_t index, int rep, int depth, const int *cells) {
+    uint64_t bit = index * _cells + rep;
+
+    if (visited[bit >> 6] >> (bit & 63) & 1) {
+      return false;
+    }
+    visited[bit >> 6] |= 1ull << (bit & 63);
+
+    if (!(seen[index >> 6] >> (index & 63) & 1)) {
+      seen[index >> 6] |= 1ull << (index & 63);
+
+      int manhattan = 0;
+      for (int i = 0; i < k; i++) {
+        int goal = _goal[group.tiles[i]];
+        manhattan += abs(goal / _side - cells[i] / _side) +
+                     abs(goal % _side - cells[i] % _side);
+      }
+
+      int value = std::min(15, (depth - manhattan) / 2);
+      data[index >> 1] |= value << ((index & 1) << 2);
+    }
+
+    return true;
+  };
+
+  std::vector<int> cells(k);
+  uint32_t occupied = 0;
+
+  for (int i = 0; i < k; i++) {
+    cells[i] = _goal[group.tiles[i]];
+    occupied |= 1u << cells[i];
+  }
+
+  uint64_t start = rank(group, cells.data());
+  int start_rep = __builtin_ctz(region(occupied, _blank_goal));
+
+  std::vector<uint64_t> current = {start * 32 + start_rep};
+  std::vector<uint64_t> next;
+
+  visit(start, start_rep, 0, cells.data());
+
+  for (int depth = 0; !current.empty(); depth++) {
+    for (uint64_t state : current) {
+      unrank(group, state / 32, cells.data());
+
+      occupied = 0;
+      for (int i = 0; i < k; i++) {
+        occupied |= 1u << cells[i];
+      }
+
+      uint32_t blank = region(occupied, state % 32);
+
+      for (int i = 0; i < k; i++) {
+        int from = cells[i];
+        int y = from / _side;
+        int x = from % _side;
+        int targets[] = {y > 0 ? from - _side : -1,
+                         y < _side - 1 ? from + _side : -1,
+                         x > 0 ? from - 1 : -1, x < _side - 1 ? from + 1 : -1};
+
+        for (int to : targets) {
+          if (to < 0 || !(blank >> to & 1)) {
+            continue;
+          }
+
+          cells[i] = to;
+
+          uint32_t moved = (occupied & ~(1u << from)) | (1u << to);
+          uint64_t index = rank(group, cells.data());
+          int rep = __builtin_ctz(region(moved, from));
+
+          if (visit(index, rep, depth + 1, cells.data())) {
+            next.push_back(index * 32 + rep);
+          }
+
+          cells[i] = from;
+        }
+      }
+    }
+
+    current.swap(next);
+    next.clear();
+  }
+}
+
+uint64_t pattern_database::rank(const group_table &group,
+                                const int *cells) const {
+  uint64_t index = 0;
+  uint32_t used = 0;
+
+  for (size_t i = 0; i < group.tiles.size(); i++) {
+    index += (cells[i] - __builtin_popcount(used & ((1u << cells[i]) - 1))) *
+             group.multipliers[i];
+    used |= 1u << cells[i];
+  }
+
+  return index;
+}
+
+void pattern_database::unrank(const group_table &group, uint64_t index,
+                              int *cells) const {
+  uint32_t used = 0;
+
+  for (size_t i = 0; i < group.tiles.size(); i++) {
+    int free_index = index / group.multipliers[i];
+    index %= group.multipliers[i];
+
+    int cell = 0;
+    for (;; cell++) {
+      if (used >> cell & 1) {
+        continue;
+      }
+      if (free_index-- == 0) {
+        break;
+      }
+    }
+
+    cells[i] = cell;
+    used |= 1u << cell;
+  }
+}
+
+uint32_t pattern_database::region(uint32_t occupied, int cell) const {
+  const uint32_t all = _cells == 32 ? ~0u : (1u << _cells) - 1;
+  const uint32_t free = all & ~occupied;
+
+  uint32_t first_column = 0;
+  for (int y = 0; y < _side; y++) {
+    first_column |= 1u << (y * _side);
+  }
+  const uint32_t last_column = first_column << (_side - 1);
+
+  uint32_t area = 1u << cell;
+  uint32_t grown = 0;
+
+  while (grown != area) {
+    grown = area;
+    area |= (((grown & ~last_column) << 1) | ((grown & ~first_column) >> 1) |
+             (grown << _side) | (grown >> _side)) &
+            free;
+  }
+
+  return area;
+}
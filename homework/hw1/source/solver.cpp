@@ -0,0 +1,281 @@
+#include "solver.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+
+#include "a_star.hpp"
+#include "heuristics.hpp"
+#include "transposition_table.hpp"
+#include "validation.hpp"
+
+static const char *heuristic_names[] = {"manhattan", "linear-conflict",
+                                        "walking-distance", "pdb"};
+
+// Checks the header numbers and sets up `p` for `numbers` tiles.
+static void start_puzzle(int numbers, int empty_tile, puzzle &p) {
+  int tiles = numbers + 1;
+  int side = sqrt(tiles);
+
+  if (numbers < 1 || side * side != tiles) {
+    throw std::invalid_argument("Invalid number of tiles.");
+  }
+
+  if ((empty_tile != -1 && (empty_tile > numbers || empty_tile < 1))) {
+    char s[255];
+    snprintf(s, 255,
+             "Invalid zero position. Valid are numbers in range 1 to %d "
+             "inclusive or -1 for default (%d).",
+             tiles, tiles);
+    throw std::invalid_argument(s);
+  }
+
+  p.board.resize(tiles);
+  p.offset_after = empty_tile != -1 ? empty_tile - 1 : numbers;
+}
+
+static void finish_puzzle(const puzzle &p) {
+  validate_board(p.board);
+
+  if (!is_solvable(p.board, p.offset_after)) {
+    throw std::invalid_argument("Not solvable.");
+  }
+}
+
+bool read_puzzle(std::istream &in, puzzle &p) {
+  int numbers, empty_tile;
+
+  if (!(in >> numbers)) {
+    return false;
+  }
+
+  in >> empty_tile;
+  start_puzzle(numbers, empty_tile, p);
+
+  for (int &tile : p.board) {
+    in >> std::ws;
+    in >> tile;
+  }
+
+  if (!in) {
+    throw std::invalid_argument("Invalid board (missing numbers)");
+  }
+
+  finish_puzzle(p);
+
+  return true;
+}
+
+// Parses the next integer at `at`, skipping leading blanks.
+static bool parse_int(const char *&at, const char *end, int &value) {
+  while (at < end && (*at == ' ' || *at == '\t' || *at == '\r')) {
+    at++;
+  }
+
+  auto [next, error] = std::from_chars(at, end, value);
+  if (error != std::errc()) {
+    return false;
+  }
+
+  at = next;
+  return true;
+}
+
+bool parse_puzzle(const std::string &line, puzzle &p) {
+  const char *at = line.data(), *end = at + line.size();
+  int numbers, empty_tile;
+
+  if (!parse_int(at, end, numbers)) {
+    return false;
+  }
+  if (!parse_int(at, end, empty_tile)) {
+    throw std::invalid_argument("Invalid zero position.");
+  }
+
+  start_puzzle(numbers, empty_tile, p);
+
+  for (int &tile : p.board) {
+    if (!parse_int(at, end, tile)) {
+      throw std::invalid_argument("Invalid board (missing numbers)");
+    }
+  }
+
+  finish_puzzle(p);
+
+  return true;
+}
+
+struct search_tables {
+  int offset_after;
+  const pattern_database *pdb;
+  const walking_distance *rows;
+  const walking_distance *columns;
+  bool linear_conflict;
+  int threads;
+  size_t tt_megabytes;
+  replacement tt_policy;
+  bool a_star;
+  size_t memory_megabytes;
+};
+
+template <int Side, typename Heuristic, typename Table>
+int search(const std::vector<int> &board, std::vector<direction> &path,
+           search_stats &stats, Heuristic policy, Table &table, int threads) {
+  if (threads > 1) {
+    return parallel_ida_star<Side>(board, path, stats, policy, table, threads);
+  }
+  return ida_star<Side>(board, path, stats, policy, table);
+}
+
+template <int Side, typename Heuristic>
+int search(const std::vector<int> &board, std::vector<direction> &path,
+           search_stats &stats, Heuristic policy,
+           const search_tables &tables) {
+  if (tables.a_star) {
+    auto begin = std::chrono::steady_clock::now();
+    int result =
+        a_star<Side>(board, path, stats, policy, tables.memory_megabytes);
+
+    if (result >= 0) {
+      return result;
+    }
+
+    // out of memory; IDA* needs none and starts over, and the counts are
+    // its own
+    path.clear();
+    stats = search_stats();
+    stats.abandoned_millis = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - begin)
+                                 .count();
+  }
+
+  if (tables.tt_megabytes) {
+    transposition_table table(board.size(), tables.tt_megabytes,
+                              tables.tt_policy);
+    return search<Side>(board, path, stats, policy, table, tables.threads);
+  }
+
+  no_transpositions table;
+  return search<Side>(board, path, stats, policy, table, tables.threads);
+}
+
+template <int Side>
+int solve(const std::vector<int> &board, std::vector<direction> &path,
+          search_stats &stats, const search_tables &tables) {
+  if (tables.pdb) {
+    return search<Side>(board, path, stats,
+                        pdb_heuristic(Side, tables.offset_after, *tables.pdb),
+                        tables);
+  }
+  if (tables.rows) {
+    return search<Side>(board, path, stats,
+                        walking_distance_heuristic(Side, tables.offset_after,
+                                                   *tables.rows,
+                                                   *tables.columns),
+                        tables);
+  }
+  if (tables.linear_conflict) {
+    return search<Side>(board, path, stats,
+                        linear_conflict_heuristic(Side, tables.offset_after),
+                        tables);
+  }
+  return search<Side>(board, path, stats,
+                      manhattan_heuristic(Side, tables.offset_after), tables);
+}
+
+// Picks the search instantiation for the board's side.
+static int solve(const std::vector<int> &board, std::vector<direction> &path,
+                 search_stats &stats, const search_tables &tables) {
+  switch (int(sqrt(board.size()))) {
+  case 2:
+    return solve<2>(board, path, stats, tables);
+  case 3:
+    return solve<3>(board, path, stats, tables);
+  case 4:
+    return solve<4>(board, path, stats, tables);
+  case 5:
+    return solve<5>(board, path, stats, tables);
+  case 6:
+    return solve<6>(board, path, stats, tables);
+  case 7:
+    return solve<7>(board, path, stats, tables);
+  case 8:
+    return solve<8>(board, path, stats, tables);
+  default:
+    throw std::invalid_argument("Unsupported board size.");
+  }
+}
+
+solver::solver(const solver_options &options) : _options(options) {
+  if (!known_heuristic(options.heuristic)) {
+    throw std::invalid_argument("Unknown heuristic " + options.heuristic);
+  }
+  if (options.engine != "ida" && options.engine != "astar") {
+    throw std::invalid_argument("Unknown engine " + options.engine);
+  }
+}
+
+bool solver::known_heuristic(const std::string &name) {
+  return std::find(std::begin(heuristic_names), std::end(heuristic_names),
+                   name) != std::end(heuristic_names);
+}
+
+void solver::prepare(const puzzle &p) {
+  int side = sqrt(p.board.size());
+
+  if (side < min_board_side || side > max_board_side) {
+    throw std::invalid_argument("Boards from 2x2 up to 8x8 are supported.");
+  }
+
+  if (_options.heuristic == "pdb") {
+    auto &pdb = _pdbs[{side, p.offset_after}];
+
+    if (!pdb) {
+      pdb = std::make_unique<pattern_database>(
+          side, p.offset_after,
+          _options.pdb_spec.empty()
+              ? pattern_database::default_sizes(side)
+              : pattern_database::parse_sizes(_options.pdb_spec),
+          _options.pdb_dir);
+    }
+  } else if (_options.heuristic == "walking-distance") {
+    // the row and column tables only differ in the blank's goal line
+    for (int line : {p.offset_after / side, p.offset_after % side}) {
+      auto &table = _walking[{side, line}];
+
+      if (!table) {
+        table = std::make_unique<walking_distance>(side, line);
+      }
+    }
+  }
+}
+
+int solver::solve(const puzzle &p, std::vector<direction> &path,
+                  search_stats &stats, int threads, int searches) const {
+  int side = sqrt(p.board.size());
+  search_tables tables = {p.offset_after,
+                          nullptr,
+                          nullptr,
+                          nullptr,
+                          _options.heuristic == "linear-conflict",
+                          threads,
+                          _options.tt_megabytes,
+                          _options.tt_policy,
+                          _options.engine == "astar",
+                          _options.memory_megabytes /
+                              std::max(searches, 1)};
+
+  if (_options.heuristic == "pdb") {
+    tables.pdb = _pdbs.at({side, p.offset_after}).get();
+  } else if (_options.heuristic == "walking-distance") {
+    tables.rows = _walking.at({side, p.offset_after / side}).get();
+    tables.columns = _walking.at({side, p.offset_after % side}).get();
+  }
+
+  return ::solve(p.board, path, stats, tables);
+}
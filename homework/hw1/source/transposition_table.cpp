@@ -0,0 +1,121 @@
+#include "transposition_table.hpp"
+
+#include <stdexcept>
+
+transposition_table::transposition_table(int cells, size_t megabytes,
+                                         replacement policy)
+    : _cells(cells), _policy(policy), _keys(cells * cells) {
+  if (megabytes == 0) {
+    throw std::invalid_argument("Transposition table needs at least 1 MB.");
+  }
+
+  // fixed seed so runs can be repeated
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+
+  for (uint64_t &key : _keys) {
+    // splitmix64
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    key = z ^ (z >> 31);
+  }
+
+  size_t buckets = 1;
+  while (buckets * 2 * bucket_size * sizeof(uint64_t) <= megabytes << 20) {
+    buckets *= 2;
+  }
+
+  _mask = buckets - 1;
+  _entries.reset(new std::atomic<uint64_t>[buckets * bucket_size]());
+}
+
+replacement transposition_table::parse_policy(const std::string &name) {
+  if (name == "depth") {
+    return replacement::depth;
+  }
+  if (name == "clock") {
+    return replacement::clock;
+  }
+  throw std::invalid_argument("Unknown replacement policy " + name);
+}
+
+bool transposition_table::visit(uint64_t hash, int depth) {
+  if (depth > max_depth) {
+    return true;
+  }
+
+  std::atomic<uint64_t> *bucket = &_entries[(hash & _mask) * bucket_size];
+  uint64_t key = hash >> 18;
+  int victim = -1;
+
+  for (int i = 0; i < bucket_size; i++) {
+    uint64_t entry = bucket[i].load(std::memory_order_relaxed);
+
+    if (stamp_of(entry) != _stamp) {
+      if (victim < 0) {
+        victim = i;
+      }
+      continue;
+    }
+    if (key_of(entry) != key) {
+      continue;
+    }
+
+    if (depth_of(entry) <= depth) {
+      if (!(entry & 1)) {
+        bucket[i].compare_exchange_weak(entry, entry | 1,
+                                        std::memory_order_relaxed);
+      }
+      return false;
+    }
+
+    bucket[i].compare_exchange_weak(entry, pack(key, _stamp, depth),
+                                    std::memory_order_relaxed);
+    return true;
+  }
+
+  if (victim < 0 && _policy == replacement::depth) {
+    int deepest = depth;
+
+    for (int i = 0; i < bucket_size; i++) {
+      int other = depth_of(bucket[i].load(std::memory_order_relaxed));
+      if (other > deepest) {
+        deepest = other;
+        victim = i;
+      }
+    }
+  } else if (victim < 0) {
+    // the hand starts at a hash-dependent slot and clears reference bits
+    // until it finds one already clear; two rounds always find one
+    int hand = hash >> 8 & (bucket_size - 1);
+
+    for (int step = 0; step < 2 * bucket_size && victim < 0; step++) {
+      int i = (hand + step) & (bucket_size - 1);
+      uint64_t entry = bucket[i].load(std::memory_order_relaxed);
+
+      if (entry & 1) {
+        bucket[i].compare_exchange_weak(entry, entry & ~uint64_t(1),
+                                        std::memory_order_relaxed);
+      } else {
+        victim = i;
+      }
+    }
+  }
+
+  if (victim >= 0) {
+    bucket[victim].store(pack(key, _stamp, depth), std::memory_order_relaxed);
+  }
+
+  return true;
+}
+
+void transposition_table::next_iteration() {
+  // stamps are 8 bits; on wrap-around the old entries have to go
+  if (++_stamp > 0xFF) {
+    _stamp = 1;
+
+    for (uint64_t i = 0; i < (_mask + 1) * bucket_size; i++) {
+      _entries[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
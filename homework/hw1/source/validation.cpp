@@ -0,0 +1,68 @@
+#include "validation.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+void validate_board(const std::vector<int> &board) {
+  int tiles = board.size();
+  std::vector<uint64_t> seen((tiles + 63) / 64, 0);
+
+  for (int n : board) {
+    if (n < 0 || n >= tiles) {
+      throw std::invalid_argument("Invalid board (invalid numbers)");
+    }
+
+    uint64_t bit = uint64_t(1) << (n & 63);
+
+    if (seen[n >> 6] & bit) {
+      throw std::invalid_argument("Invalid board (dupicate numbers)");
+    }
+    seen[n >> 6] |= bit;
+  }
+}
+
+long long count_inversions(const std::vector<int> &board) {
+  int tiles = board.size();
+  // tree[i] counts the tiles seen so far in a range of values ending at i
+  std::vector<int> tree(tiles, 0);
+  long long inversions = 0;
+
+  // from the right, every smaller tile already seen is an inversion
+  for (int i = tiles - 1; i >= 0; i--) {
+    int tile = board[i];
+
+    if (!tile) {
+      continue;
+    }
+
+    for (int at = tile - 1; at > 0; at -= at & -at) {
+      inversions += tree[at];
+    }
+    for (int at = tile; at < tiles; at += at & -at) {
+      tree[at]++;
+    }
+  }
+
+  return inversions;
+}
+
+bool is_solvable(const std::vector<int> &board, int blank_goal) {
+  int side = sqrt(board.size());
+  int blank = 0;
+
+  while (board[blank]) {
+    blank++;
+  }
+
+  long long inversions = count_inversions(board);
+
+  // the goal has no inversions; on odd sides every move keeps the parity of
+  // the inversions, on even sides vertical moves also flip it along with
+  // the blank's row
+  if (side & 1) {
+    return !(inversions & 1);
+  }
+
+  return !((inversions + blank / side + blank_goal / side) & 1);
+}
@@ -0,0 +1,130 @@
+#include "walking_distance.hpp"
+
+#include <stdexcept>
+
+// Counts take three bits each; the last goal line of every line follows from
+// the others and is not stored.
+static const int count_bits = 3;
+
+walking_distance::walking_distance(int side, int blank_line) : _side(side) {
+  // the 5x5 table has too many states to keep in memory
+  if (side > 4) {
+    throw std::invalid_argument(
+        "Walking distance supports boards up to 4x4 only.");
+  }
+
+  std::vector<int> counts(side * side, 0);
+  for (int line = 0; line < side; line++) {
+    counts[line * side + line] = side - (line == blank_line);
+  }
+
+  std::vector<uint64_t> queue = {encode(counts, blank_line)};
+  _ids[queue[0]] = 0;
+  _distances.push_back(0);
+
+  // breadth-first from the goal; moves are reversible
+  for (size_t i = 0; i < queue.size(); i++) {
+    int blank;
+    decode(queue[i], counts, blank);
+
+    for (int forward = 0; forward < 2; forward++) {
+      int from = forward ? blank + 1 : blank - 1;
+
+      if (from < 0 || from >= side) {
+        continue;
+      }
+
+      for (int goal_line = 0; goal_line < side; goal_line++) {
+        if (!counts[from * side + goal_line]) {
+          continue;
+        }
+
+        counts[from * side + goal_line]--;
+        counts[blank * side + goal_line]++;
+
+        uint64_t key = encode(counts, from);
+
+        if (_ids.emplace(key, queue.size()).second) {
+          queue.push_back(key);
+          _distances.push_back(_distances[i] + 1);
+        }
+
+        counts[from * side + goal_line]++;
+        counts[blank * side + goal_line]--;
+      }
+    }
+  }
+
+  _next = std::vector<int>(queue.size() * 2 * side, -1);
+
+  for (size_t i = 0; i < queue.size(); i++) {
+    int blank;
+    decode(queue[i], counts, blank);
+
+    for (int forward = 0; forward < 2; forward++) {
+      int from = forward ? blank + 1 : blank - 1;
+
+      if (from < 0 || from >= side) {
+        continue;
+      }
+
+      for (int goal_line = 0; goal_line < side; goal_line++) {
+        if (!counts[from * side + goal_line]) {
+          continue;
+        }
+
+        counts[from * side + goal_line]--;
+        counts[blank * side + goal_line]++;
+
+        _next[(i * 2 + forward) * side + goal_line] =
+            _ids.at(encode(counts, from));
+
+        counts[from * side + goal_line]++;
+        counts[blank * side + goal_line]--;
+      }
+    }
+  }
+}
+
+int walking_distance::state(const std::vector<int> &counts, int blank) const {
+  auto it = _ids.find(encode(counts, blank));
+
+  if (it == _ids.end()) {
+    throw std::invalid_argument("Unreachable walking distance state.");
+  }
+
+  return it->second;
+}
+
+uint64_t walking_distance::encode(const std::vector<int> &counts,
+                                  int blank) const {
+  uint64_t key = blank;
+
+  for (int line = 0; line < _side; line++) {
+    for (int goal_line = 0; goal_line < _side - 1; goal_line++) {
+      key = key << count_bits | counts[line * _side + goal_line];
+    }
+  }
+
+  return key;
+}
+
+void walking_distance::decode(uint64_t key, std::vector<int> &counts,
+                              int &blank) const {
+  for (int line = _side - 1; line >= 0; line--) {
+    for (int goal_line = _side - 2; goal_line >= 0; goal_line--) {
+      counts[line * _side + goal_line] = key & ((1 << count_bits) - 1);
+      key >>= count_bits;
+    }
+  }
+
+  blank = key;
+
+  for (int line = 0; line < _side; line++) {
+    int sum = 0;
+    for (int goal_line = 0; goal_line < _side - 1; goal_line++) {
+      sum += counts[line * _side + goal_line];
+    }
+    counts[line * _side + _side - 1] = _side - (line == blank) - sum;
+  }
+}
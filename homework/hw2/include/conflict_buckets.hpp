@@ -0,0 +1,88 @@
+#ifndef CONFLICT_BUCKETS_HPP
+#define CONFLICT_BUCKETS_HPP
+
+#include <vector>
+
+// Variables grouped by their current conflict count. Moving a variable to
+// another count and picking a random variable among the most conflicted
+// are O(1) (amortized when the maximum drops).
+class conflict_buckets {
+public:
+  explicit conflict_buckets(int variables = 0)
+      : _value(variables, 0), _position(variables, 0) {}
+
+  // Resets every variable to `values[variable]`.
+  void assign(const std::vector<int> &values) {
+    _value = values;
+    _position.resize(values.size());
+    for (auto &bucket : _buckets) {
+      bucket.clear();
+    }
+    _max = 0;
+    _total = 0;
+
+    for (size_t variable = 0; variable < values.size(); variable++) {
+      insert(variable, values[variable]);
+    }
+  }
+
+  int value(int variable) const { return _value[variable]; }
+
+  // Sum of every variable's count.
+  long long total() const { return _total; }
+
+  int max() {
+    while (_max > 0 && _buckets[_max].empty()) {
+      _max--;
+    }
+    return _max;
+  }
+
+  void change(int variable, int value) {
+    if (value != _value[variable]) {
+      remove(variable);
+      insert(variable, value);
+    }
+  }
+
+  // Random variable among those with the highest count, drawn with `random`
+  // (a callable returning a uniform index below its argument).
+  template <typename Random> int random_max(Random &&random) {
+    const std::vector<int> &bucket = _buckets[max()];
+    return bucket[random(bucket.size())];
+  }
+
+private:
+  std::vector<std::vector<int>> _buckets;
+  std::vector<int> _value;
+  std::vector<int> _position;
+  int _max = 0;
+  long long _total = 0;
+
+  void insert(int variable, int value) {
+    if (value >= int(_buckets.size())) {
+      _buckets.resize(value + 1);
+    }
+
+    _value[variable] = value;
+    _total += value;
+    _position[variable] = _buckets[value].size();
+    _buckets[value].push_back(variable);
+
+    if (value > _max) {
+      _max = value;
+    }
+  }
+
+  void remove(int variable) {
+    std::vector<int> &bucket = _buckets[_value[variable]];
+    int last = bucket.back();
+
+    bucket[_position[variable]] = last;
+    _position[last] = _position[variable];
+    bucket.pop_back();
+    _total -= _value[variable];
+  }
+};
+
+#endif
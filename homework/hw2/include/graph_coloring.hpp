@@ -0,0 +1,105 @@
+#ifndef GRAPH_COLORING_HPP
+#define GRAPH_COLORING_HPP
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "conflict_buckets.hpp"
+
+// Graph coloring as a min_conflicts policy: every vertex is a variable, the
+// colors are its values and every edge between equal colors is a conflict.
+class graph_coloring {
+public:
+  graph_coloring(int vertices, const std::vector<std::pair<int, int>> &edges,
+                 int colors);
+
+  int variables() const { return _color.size(); }
+  int colors() const { return _colors; }
+  int value(int vertex) const { return _color[vertex]; }
+
+  // Greedy: every vertex takes a color least used by the neighbours colored
+  // before it.
+  template <typename Random> void init(Random &random) {
+    _color.assign(variables(), -1);
+
+    for (int vertex = 0; vertex < variables(); vertex++) {
+      int best = -1, minCount = 0, ties = 0;
+
+      count_neighbour_colors(vertex);
+      for (int color = 0; color < _colors; color++) {
+        if (best == -1 || _count[color] < minCount) {
+          best = color;
+          minCount = _count[color];
+          ties = 1;
+        } else if (_count[color] == minCount && random(++ties) == 0) {
+          best = color;
+        }
+      }
+      clear_neighbour_colors(vertex);
+
+      _color[vertex] = best;
+    }
+
+    std::vector<int> conflicts(variables());
+    for (int vertex = 0; vertex < variables(); vertex++) {
+      for (int at = _first[vertex]; at < _first[vertex + 1]; at++) {
+        conflicts[vertex] += _color[_adjacent[at]] == _color[vertex];
+      }
+    }
+    _buckets.assign(conflicts);
+  }
+
+  template <typename Random> int conflicted(Random &random) {
+    return _buckets.max() ? _buckets.random_max(random) : -1;
+  }
+
+  template <typename Visit> void candidates(int vertex, Visit visit) {
+    count_neighbour_colors(vertex);
+    for (int color = 0; color < _colors; color++) {
+      visit(color, _count[color]);
+    }
+    clear_neighbour_colors(vertex);
+  }
+
+  template <typename Random> int random_value(int, Random &random) {
+    return random(_colors);
+  }
+
+  void assign(int vertex, int color);
+
+private:
+  int _colors;
+  // adjacency lists, those of vertex v are _adjacent[_first[v].._first[v+1])
+  std::vector<int> _first;
+  std::vector<int> _adjacent;
+  std::vector<int> _color;
+  // neighbours per color of the vertex being scored, all zero otherwise
+  std::vector<int> _count;
+  conflict_buckets _buckets;
+
+  // Neighbours without a color yet (-1) are not counted.
+  void count_neighbour_colors(int vertex) {
+    for (int at = _first[vertex]; at < _first[vertex + 1]; at++) {
+      int color = _color[_adjacent[at]];
+      if (color != -1) {
+        _count[color]++;
+      }
+    }
+  }
+
+  void clear_neighbour_colors(int vertex) {
+    for (int at = _first[vertex]; at < _first[vertex + 1]; at++) {
+      int color = _color[_adjacent[at]];
+      if (color != -1) {
+        _count[color] = 0;
+      }
+    }
+  }
+};
+
+// Reads a DIMACS graph ("p edge V E" and "e u v" lines with vertices from
+// 1, "c" lines are comments); throws std::runtime_error if it is malformed.
+graph_coloring read_dimacs(std::FILE *in, int colors);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef INDEX_POOL_HPP
+#define INDEX_POOL_HPP
+
+#include <vector>
+
+// A set of indices below a fixed size with O(1) insert, erase, membership
+// and uniform random pick. Members are kept packed in `items`, and
+// `_position` maps every index to its slot there (or -1).
+class index_pool {
+public:
+  explicit index_pool(int size = 0) : _position(size, -1) {}
+
+  void reset(int size) {
+    _items.clear();
+    _position.assign(size, -1);
+  }
+
+  bool contains(int index) const { return _position[index] != -1; }
+  bool empty() const { return _items.empty(); }
+  int size() const { return _items.size(); }
+  int operator[](int slot) const { return _items[slot]; }
+
+  void insert(int index) {
+    if (_position[index] == -1) {
+      _position[index] = _items.size();
+      _items.push_back(index);
+    }
+  }
+
+  void erase(int index) {
+    int slot = _position[index];
+
+    if (slot != -1) {
+      int last = _items.back();
+      _items[slot] = last;
+      _position[last] = slot;
+      _items.pop_back();
+      _position[index] = -1;
+    }
+  }
+
+  template <typename Random> int random(Random &&random) const {
+    return _items[random(_items.size())];
+  }
+
+private:
+  std::vector<int> _items;
+  std::vector<int> _position;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef LINE_COUNTERS_HPP
+#define LINE_COUNTERS_HPP
+
+#include <cstddef>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+// Counters stored in `Count`. A counter that reaches the largest `Count`
+// stays saturated there and its real value moves to a wide side table, so
+// narrow types only cost extra on the (rare) crowded lines.
+template <typename Count> class counter_array {
+public:
+  static constexpr int saturated = std::numeric_limits<Count>::max();
+
+  void reset(int size) {
+    _narrow.assign(size, 0);
+    _wide.clear();
+  }
+
+  int get(int index) const {
+    int value = _narrow[index];
+    return value == saturated ? _wide.at(index) : value;
+  }
+
+  // Both return the new value.
+  int increment(int index) {
+    int value = _narrow[index];
+
+    if (value < saturated - 1) {
+      _narrow[index] = value + 1;
+      return value + 1;
+    }
+    if (value == saturated - 1) {
+      _narrow[index] = saturated;
+      return _wide[index] = saturated;
+    }
+    return ++_wide[index];
+  }
+
+  int decrement(int index) {
+    int value = _narrow[index];
+
+    if (value != saturated) {
+      _narrow[index] = value - 1;
+      return value - 1;
+    }
+    if (--_wide[index] < saturated) {
+      _wide.erase(index);
+      _narrow[index] = saturated - 1;
+      return saturated - 1;
+    }
+    return _wide[index];
+  }
+
+  // The narrow counters; saturated ones read as `saturated`.
+  const Count *data() const { return _narrow.data(); }
+
+  size_t bytes() const {
+    return _narrow.capacity() * sizeof(Count) +
+           _wide.size() * (sizeof(int) * 2 + sizeof(void *) * 2);
+  }
+
+private:
+  std::vector<Count> _narrow;
+  std::unordered_map<int, int> _wide;
+};
+
+// Queens on every row and diagonal of an NxN board. D1 diagonals are
+// indexed by col - row + N - 1 and D2 by col + row.
+template <typename Count> class line_counters {
+public:
+  using count_type = Count;
+  static constexpr int saturated = counter_array<Count>::saturated;
+
+  void reset(int n) {
+    _n = n;
+    _rows.reset(n);
+    _d1.reset(2 * n - 1);
+    _d2.reset(2 * n - 1);
+  }
+
+  int rows() const { return _n; }
+  int row(int row) const { return _rows.get(row); }
+  int d1(int row, int col) const { return _d1.get(d1_index(row, col)); }
+  int d2(int row, int col) const { return _d2.get(d2_index(row, col)); }
+
+  // Queens already on the three lines through the square.
+  int conflicts(int row, int col) const {
+    return this->row(row) + d1(row, col) + d2(row, col);
+  }
+
+  // Both return whether the row was empty before / is empty after.
+  bool place(int row, int col) {
+    _d1.increment(d1_index(row, col));
+    _d2.increment(d2_index(row, col));
+    return _rows.increment(row) == 1;
+  }
+
+  bool remove(int row, int col) {
+    _d1.decrement(d1_index(row, col));
+    _d2.decrement(d2_index(row, col));
+    return _rows.decrement(row) == 0;
+  }
+
+  size_t bytes() const { return _rows.bytes() + _d1.bytes() + _d2.bytes(); }
+
+  // Raw narrow counters, indexed as above.
+  const Count *row_data() const { return _rows.data(); }
+  const Count *d1_data() const { return _d1.data(); }
+  const Count *d2_data() const { return _d2.data(); }
+
+private:
+  int _n = 0;
+  counter_array<Count> _rows;
+  counter_array<Count> _d1;
+  counter_array<Count> _d2;
+
+  int d1_index(int row, int col) const { return col - row + _n - 1; }
+
+  int d2_index(int row, int col) const { return col + row; }
+};
+
+#endif
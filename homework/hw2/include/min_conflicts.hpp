@@ -0,0 +1,140 @@
+#ifndef MIN_CONFLICTS_HPP
+#define MIN_CONFLICTS_HPP
+
+#include <atomic>
+#include <climits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Min-conflicts local search over any problem given as a compile-time
+// policy. `Problem` provides
+//
+//   int variables() const;
+//   void init(Random &random);       fresh assignment, starts a restart
+//   int value(int variable) const;
+//   int conflicted(Random &random);  random conflicted variable, -1 if none
+//   void candidates(int variable, Visit visit);
+//       calls visit(value, conflicts) for the values worth trying, where
+//       `conflicts` is what the variable would have with that value
+//   int random_value(int variable, Random &random);
+//   void assign(int variable, int value);  updates conflicts incrementally
+//
+// and `Random` returns a uniform integer below its argument. A problem that
+// can find its best value faster than by visiting the candidates one by one
+// may also provide
+//
+//   int best_value(int variable, Random &random);
+//       the candidate with the fewest conflicts, ties broken uniformly
+//
+// which is then used for every step that has no tabu value to skip.
+
+// Whether `Problem` provides best_value for `Random`.
+template <typename Problem, typename Random, typename = void>
+struct has_best_value : std::false_type {};
+
+template <typename Problem, typename Random>
+struct has_best_value<Problem, Random,
+                      std::void_t<decltype(std::declval<Problem &>().best_value(
+                          0, std::declval<Random &>()))>> : std::true_type {};
+
+struct min_conflicts_options {
+  // steps before a restart
+  long long max_steps = 1000;
+  // restarts before giving up, 0 for no limit
+  long long max_restarts = 0;
+  // chance of a random value instead of the best one (random walk)
+  double walk = 0;
+  // steps a variable may not return to the value it just left
+  int tabu = 0;
+};
+
+struct min_conflicts_stats {
+  long long restarts = 0;
+  long long steps = 0;
+};
+
+template <typename Problem, typename Random>
+bool min_conflicts(Problem &problem, const min_conflicts_options &options,
+                   Random &&random, const std::atomic<bool> &stop,
+                   min_conflicts_stats &stats) {
+  // the value every variable left last and the step until which it is tabu
+  std::vector<int> tabuValue;
+  std::vector<long long> tabuUntil;
+  const unsigned walkThreshold = options.walk * (1u << 20);
+
+  for (long long restart = 0;
+       !options.max_restarts || restart < options.max_restarts; restart++) {
+    if (stop.load(std::memory_order_relaxed)) {
+      return false;
+    }
+
+    problem.init(random);
+    stats.restarts++;
+
+    if (options.tabu) {
+      tabuValue.assign(problem.variables(), -1);
+      tabuUntil.assign(problem.variables(), 0);
+    }
+
+    for (long long step = 0; step < options.max_steps; step++) {
+      if (stop.load(std::memory_order_relaxed)) {
+        return false;
+      }
+
+      int variable = problem.conflicted(random);
+
+      if (variable == -1) {
+        return true;
+      }
+
+      int last = problem.value(variable);
+      int value = -1;
+
+      if (walkThreshold && unsigned(random(1u << 20)) < walkThreshold) {
+        value = problem.random_value(variable, random);
+      } else if constexpr (has_best_value<Problem, Random>::value) {
+        if (!options.tabu) {
+          value = problem.best_value(variable, random);
+        }
+      }
+
+      if (value == -1) {
+        int minConflicts = INT_MAX;
+        int ties = 0;
+
+        problem.candidates(variable, [&](int candidate, int conflicts) {
+          // a tabu value is still taken if it removes every conflict
+          if (options.tabu && conflicts && candidate == tabuValue[variable] &&
+              step < tabuUntil[variable]) {
+            return;
+          }
+
+          if (minConflicts > conflicts) {
+            minConflicts = conflicts;
+            value = candidate;
+            ties = 1;
+          } else if (minConflicts == conflicts && random(++ties) == 0) {
+            value = candidate;
+          }
+        });
+
+        if (value == -1) {
+          value = last;
+        }
+      }
+
+      if (options.tabu && value != last) {
+        tabuValue[variable] = last;
+        tabuUntil[variable] = step + options.tabu;
+      }
+
+      problem.assign(variable, value);
+      stats.steps++;
+    }
+  }
+
+  return false;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstdint>
+
+// xoshiro256** by Blackman and Vigna: four words of state, a few shifts and
+// rotations per number and far better statistics than its cost suggests.
+class xoshiro256 {
+public:
+  using result_type = uint64_t;
+
+  explicit xoshiro256(uint64_t seed = 0) { this->seed(seed); }
+
+  // Expands `seed` with splitmix64, so nearby seeds give unrelated streams.
+  void seed(uint64_t seed) {
+    for (uint64_t &word : _state) {
+      seed += 0x9e3779b97f4a7c15;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      word = z ^ (z >> 31);
+    }
+  }
+
+  static constexpr uint64_t min() { return 0; }
+  static constexpr uint64_t max() { return UINT64_MAX; }
+
+  uint64_t operator()() {
+    uint64_t result = rotl(_state[1] * 5, 7) * 9;
+    uint64_t t = _state[1] << 17;
+
+    _state[2] ^= _state[0];
+    _state[3] ^= _state[1];
+    _state[1] ^= _state[2];
+    _state[0] ^= _state[3];
+    _state[2] ^= t;
+    _state[3] = rotl(_state[3], 45);
+
+    return result;
+  }
+
+  // Uniform below `bound` (at least 1) without a division in the common
+  // case: Lemire's multiply-shift, rejecting the few biased products.
+  uint32_t below(uint32_t bound) {
+    uint64_t product = uint64_t(uint32_t((*this)() >> 32)) * bound;
+    uint32_t low = uint32_t(product);
+
+    if (low < bound) {
+      uint32_t threshold = uint32_t(-bound) % bound;
+      while (low < threshold) {
+        product = uint64_t(uint32_t((*this)() >> 32)) * bound;
+        low = uint32_t(product);
+      }
+    }
+
+    return product >> 32;
+  }
+
+private:
+  uint64_t _state[4];
+
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef ROW_SCORING_HPP
+#define ROW_SCORING_HPP
+
+#include <climits>
+#include <cstdint>
+#include <type_traits>
+
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+    (defined(__x86_64__) || defined(__i386__))
+#define ROW_SCORING_AVX2 1
+#include <immintrin.h>
+#endif
+
+// Scoring every row of one column at once. Row r of column `col` scores
+// rows[r] + d1[col - r + n - 1] + d2[col + r], less `discount` on row
+// `current`; the lowest score wins and ties are broken uniformly with
+// `random` (a callable returning a uniform integer below its argument).
+struct row_choice {
+  int row;
+  int conflicts;
+};
+
+// Adds `count` tied rows, the `pick`-th of which is drawn by `pick_tied`,
+// to a reservoir of `ties` rows.
+template <typename Random, typename Pick>
+void reservoir_add(int count, int &ties, row_choice &best, Random &random,
+                   Pick pick_tied) {
+  ties += count;
+  if (int(random(ties)) < count) {
+    best.row = pick_tied(count == 1 ? 0 : int(random(count)));
+  }
+}
+
+template <typename Count, typename Random>
+row_choice scan_rows_scalar(const Count *rows, const Count *d1,
+                            const Count *d2, int n, int col, int current,
+                            int discount, Random &&random, int from = 0) {
+  row_choice best{-1, INT_MAX};
+  int ties = 0;
+
+  for (int row = from; row < n; row++) {
+    int conflicts = rows[row] + d1[col - row + n - 1] + d2[col + row] -
+                    (row == current ? discount : 0);
+
+    if (conflicts < best.conflicts) {
+      best = {row, conflicts};
+      ties = 1;
+    } else if (conflicts == best.conflicts) {
+      reservoir_add(1, ties, best, random, [row](int) { return row; });
+    }
+  }
+
+  return best;
+}
+
+#ifdef ROW_SCORING_AVX2
+
+inline bool has_avx2() {
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+
+// Eight consecutive counters widened to 32 bits.
+template <typename Count>
+__attribute__((target("avx2"))) inline __m256i load8(const Count *at) {
+  if constexpr (sizeof(Count) == 1) {
+    return _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(at)));
+  } else if constexpr (sizeof(Count) == 2) {
+    return _mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(at)));
+  } else {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(at));
+  }
+}
+
+// Eight rows per step: the rows and D2 counters are contiguous and the D1
+// counters are contiguous in reverse. A block is only looked at closer if
+// its minimum is not above the best score so far.
+template <typename Count, typename Random>
+__attribute__((target("avx2"))) row_choice
+scan_rows_avx2(const Count *rows, const Count *d1, const Count *d2, int n,
+               int col, int current, int discount, Random &&random) {
+  static_assert(std::is_unsigned<Count>::value || sizeof(Count) == 4,
+                "narrow counters are widened as unsigned");
+
+  const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i currentRow = _mm256_set1_epi32(current);
+  const __m256i discounts = _mm256_set1_epi32(discount);
+
+  row_choice best{-1, INT_MAX};
+  int ties = 0;
+  int row = 0;
+
+  for (; row + 8 <= n; row += 8) {
+    __m256i index = _mm256_add_epi32(_mm256_set1_epi32(row), lanes);
+    __m256i diagonal = _mm256_permutevar8x32_epi32(
+        load8(d1 + (col - row + n - 8)), reverse);
+    __m256i sum = _mm256_add_epi32(
+        _mm256_add_epi32(load8(rows + row), load8(d2 + col + row)), diagonal);
+    sum = _mm256_sub_epi32(
+        sum, _mm256_and_si256(_mm256_cmpeq_epi32(index, currentRow),
+                              discounts));
+
+    __m256i min = _mm256_min_epi32(sum, _mm256_permute2x128_si256(sum, sum, 1));
+    min = _mm256_min_epi32(min, _mm256_shuffle_epi32(min, 0x4e));
+    min = _mm256_min_epi32(min, _mm256_shuffle_epi32(min, 0xb1));
+    int blockMin = _mm256_cvtsi256_si32(min);
+
+    if (blockMin > best.conflicts) {
+      continue;
+    }
+    if (blockMin < best.conflicts) {
+      best.conflicts = blockMin;
+      ties = 0;
+    }
+
+    unsigned mask = _mm256_movemask_ps(
+        _mm256_castsi256_ps(_mm256_cmpeq_epi32(sum, min)));
+
+    reservoir_add(__builtin_popcount(mask), ties, best, random, [&](int pick) {
+      unsigned bits = mask;
+      while (pick--) {
+        bits &= bits - 1;
+      }
+      return row + __builtin_ctz(bits);
+    });
+  }
+
+  if (row < n) {
+    row_choice tail = scan_rows_scalar(rows, d1, d2, n, col, current,
+                                       discount, random, row);
+    int tailTies = 0;
+
+    // count the tail's ties again to merge both reservoirs
+    for (int r = row; r < n; r++) {
+      tailTies += rows[r] + d1[col - r + n - 1] + d2[col + r] -
+                      (r == current ? discount : 0) ==
+                  tail.conflicts;
+    }
+
+    if (tail.conflicts < best.conflicts) {
+      best = tail;
+    } else if (tail.conflicts == best.conflicts) {
+      reservoir_add(tailTies, ties, best, random,
+                    [&](int) { return tail.row; });
+    }
+  }
+
+  return best;
+}
+
+#else
+
+inline bool has_avx2() { return false; }
+
+template <typename Count, typename Random>
+row_choice scan_rows_avx2(const Count *rows, const Count *d1, const Count *d2,
+                          int n, int col, int current, int discount,
+                          Random &&random) {
+  return scan_rows_scalar(rows, d1, d2, n, col, current, discount, random);
+}
+
+#endif
+
+#endif
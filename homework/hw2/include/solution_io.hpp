@@ -0,0 +1,52 @@
+#ifndef SOLUTION_IO_HPP
+#define SOLUTION_IO_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Appends to a FILE through a large buffer, so writing millions of small
+// pieces costs one fwrite per buffer. Throws std::runtime_error if writing
+// fails.
+class buffered_writer {
+public:
+  explicit buffered_writer(std::FILE *file, size_t capacity = 1 << 20);
+  ~buffered_writer();
+
+  buffered_writer(const buffered_writer &) = delete;
+  buffered_writer &operator=(const buffered_writer &) = delete;
+
+  void write(const char *data, size_t size);
+  void put(char c) {
+    if (_size == _buffer.size()) {
+      flush();
+    }
+    _buffer[_size++] = c;
+  }
+  void write_int(long long value);
+  void flush();
+
+private:
+  std::FILE *_file;
+  std::vector<char> _buffer;
+  size_t _size = 0;
+};
+
+// A solution lists the row of the queen in every column.
+//
+// "text": N on the first line, then one row per line.
+// "binary": N and the rows as native-endian 32-bit integers.
+// "board": the rendered board ('*' and '_'), one row per line. It is written
+// row by row from an O(N) buffer and cannot be read back.
+void write_solution(buffered_writer &out, const std::vector<int> &nQueens,
+                    const std::string &format);
+
+// Reads a "text" or "binary" solution; throws std::runtime_error if it is
+// malformed.
+std::vector<int> read_solution(std::FILE *in, const std::string &format);
+
+// Whether the queens attack each other, in O(N) with one counter per row
+// and diagonal.
+bool verify_solution(const std::vector<int> &nQueens);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <cstddef>
+
+// Peak resident set size of the process so far, in bytes (0 if unknown).
+size_t peak_rss();
+
+// Hardware cache misses of the calling thread and the threads it starts
+// afterwards, from Linux perf events. Unavailable (and -1) elsewhere or when
+// the kernel does not allow it.
+class cache_miss_counter {
+public:
+  cache_miss_counter();
+  ~cache_miss_counter();
+
+  cache_miss_counter(const cache_miss_counter &) = delete;
+  cache_miss_counter &operator=(const cache_miss_counter &) = delete;
+
+  bool available() const { return _fd != -1; }
+  long long read() const;
+
+private:
+  int _fd = -1;
+};
+
+#endif
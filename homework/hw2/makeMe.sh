@@ -26,6 +26,7 @@ FLAGS="-O2\
     -pedantic\
     -Wextra\
     --std=c++17\
+    -pthread\
     -I "./include"\
     "
 
@@ -0,0 +1,81 @@
+#include "graph_coloring.hpp"
+
+#include <stdexcept>
+
+graph_coloring::graph_coloring(int vertices,
+                               const std::vector<std::pair<int, int>> &edges,
+                               int colors)
+    : _colors(colors), _first(vertices + 1, 0), _adjacent(2 * edges.size()),
+      _color(vertices, -1), _count(colors, 0) {
+  if (colors < 1) {
+    throw std::invalid_argument("Invalid number of colors.");
+  }
+
+  for (auto [u, v] : edges) {
+    _first[u + 1]++;
+    _first[v + 1]++;
+  }
+  for (int vertex = 0; vertex < vertices; vertex++) {
+    _first[vertex + 1] += _first[vertex];
+  }
+
+  std::vector<int> at(_first.begin(), _first.end() - 1);
+  for (auto [u, v] : edges) {
+    _adjacent[at[u]++] = v;
+    _adjacent[at[v]++] = u;
+  }
+}
+
+void graph_coloring::assign(int vertex, int color) {
+  int last = _color[vertex];
+  int conflicts = 0;
+
+  if (color == last) {
+    return;
+  }
+
+  for (int at = _first[vertex]; at < _first[vertex + 1]; at++) {
+    int neighbour = _adjacent[at];
+
+    if (_color[neighbour] == last) {
+      _buckets.change(neighbour, _buckets.value(neighbour) - 1);
+    } else if (_color[neighbour] == color) {
+      _buckets.change(neighbour, _buckets.value(neighbour) + 1);
+      conflicts++;
+    }
+  }
+
+  _color[vertex] = color;
+  _buckets.change(vertex, conflicts);
+}
+
+graph_coloring read_dimacs(std::FILE *in, int colors) {
+  char line[256];
+  int vertices = -1;
+  std::vector<std::pair<int, int>> edges;
+
+  while (fgets(line, sizeof(line), in)) {
+    int u, v;
+
+    if (line[0] == 'p') {
+      char kind[32];
+      if (sscanf(line, "p %31s %d", kind, &vertices) != 2 || vertices < 0) {
+        throw std::runtime_error("Invalid graph (bad problem line)");
+      }
+    } else if (line[0] == 'e') {
+      if (sscanf(line, "e %d %d", &u, &v) != 2 || vertices < 0 || u < 1 ||
+          v < 1 || u > vertices || v > vertices) {
+        throw std::runtime_error("Invalid graph (bad edge)");
+      }
+      if (u != v) {
+        edges.emplace_back(u - 1, v - 1);
+      }
+    }
+  }
+
+  if (vertices < 0) {
+    throw std::runtime_error("Invalid graph (no problem line)");
+  }
+
+  return graph_coloring(vertices, edges, colors);
+}
@@ -1,11 +1,32 @@
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
 #include <iostream>
-#include <random>
 #include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <time.h>
 #include <vector>
 
-std::mt19937 mt(time(NULL));
+#include "conflict_buckets.hpp"
+#include "graph_coloring.hpp"
+#include "index_pool.hpp"
+#include "line_counters.hpp"
+#include "min_conflicts.hpp"
+#include "random.hpp"
+#include "row_scoring.hpp"
+#include "solution_io.hpp"
+#include "telemetry.hpp"
+
+// Every thread draws from its own generator; workers reseed theirs.
+thread_local xoshiro256 rng(time(NULL));
+
+uint32_t random_below(size_t bound) { return rng.below(bound); }
 
 void pause() {
   std::cout << "Enter anything to continue..." << std::endl;
@@ -14,218 +35,927 @@ void pause() {
   std::cin >> c;
 }
 
-void print_board(std::vector<int> &nQueens) {
-  for (size_t i = 0; i < nQueens.size(); i++) {
-    for (size_t j = 0; j < nQueens.size(); j++) {
-      std::cout << (nQueens[j] == (int)i ? '*' : '_') << ' ';
+// Which rows are scored when a queen is placed or moved: all of them,
+// `samples` random ones, or `samples` random rows that hold no queen. The
+// queen's current row is always a candidate when it is moved.
+enum class row_mode { full, sample, free };
+
+// How the first placement is built: column by column on the best scored
+// row, or on random free rows whose diagonals are free too.
+enum class init_mode { greedy, linear };
+
+// Whether full row scans use the AVX2 kernel when the CPU has it, never, or
+// run both and abort if they disagree.
+enum class simd_mode { detect, off, check };
+
+struct solve_options {
+  init_mode init = init_mode::linear;
+  row_mode rows = row_mode::full;
+  int samples = 32;
+  int threads = 1;
+  // bits per line counter (8, 16 or 32), see line_counters
+  int counter_bits = 32;
+  // "queens" for the dedicated loop, "csp" for min_conflicts with
+  // queens_problem, which also takes the random walk chance and the tabu
+  // tenure, or "construct" for the explicit placement
+  std::string engine = "queens";
+  double walk = 0;
+  int tabu = 0;
+  simd_mode simd = simd_mode::detect;
+  // worker w seeds its generator with seed + w
+  uint64_t seed = 0;
+};
+
+// Total conflicts (every queen counts the queens attacking it) after
+// `iteration` repair iterations of the current restart.
+struct trace_point {
+  long long iteration;
+  long long nanos;
+  long long conflicts;
+};
+
+struct solve_stats {
+  long long restarts = 0;
+  long long iterations = 0;
+  size_t counter_bytes = 0;
+  // time in init and in the repair loop
+  long long init_nanos = 0;
+  long long repair_nanos = 0;
+  // at the start of every restart and after every power of two iterations
+  std::vector<trace_point> trace;
+};
+
+long long nanos_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Calls visit(row) for every candidate row, see row_mode.
+template <typename Visit>
+void for_each_candidate_row(int n, int current, const solve_options &options,
+                            const index_pool &freeRows, Visit visit) {
+  if (options.rows == row_mode::full) {
+    for (int row = 0; row < n; row++) {
+      visit(row);
+    }
+    return;
+  }
+
+  if (current != -1) {
+    visit(current);
+  }
+
+  for (int i = 0; i < options.samples; i++) {
+    if (options.rows == row_mode::free && !freeRows.empty()) {
+      visit(freeRows.random(random_below));
+    } else {
+      visit(random_below(n));
     }
-    std::cout << std::endl;
   }
-  std::cout << std::endl;
 }
 
-int find_conflicts(int n, int row, int col, std::vector<int> &queensPerRow,
-                   std::vector<int> &queensPerD1,
-                   std::vector<int> &queensPerD2) {
-  const int dOffset = n - 1;
+// Lowest-scoring candidate row; ties are broken uniformly by reservoir
+// sampling, so nothing is allocated.
+template <typename Score>
+int best_row(int n, int current, const solve_options &options,
+             const index_pool &freeRows, Score score) {
+  int minConflicts = INT32_MAX;
+  int minRow = -1;
+  int ties = 0;
+
+  for_each_candidate_row(n, current, options, freeRows, [&](int row) {
+    int conflicts = score(row);
 
-  return queensPerRow[row] + queensPerD1[col - row + dOffset] +
-         queensPerD2[col + row];
+    if (minConflicts > conflicts) {
+      minConflicts = conflicts;
+      minRow = row;
+      ties = 1;
+    } else if (minConflicts == conflicts && random_below(++ties) == 0) {
+      minRow = row;
+    }
+  });
+
+  return minRow;
 }
 
-bool has_conflicts(std::vector<int> &queensPerRow,
-                   std::vector<int> &queensPerD1,
-                   std::vector<int> &queensPerD2) {
-  for (size_t i = 0; i < queensPerD1.size(); i++) {
-    if (queensPerRow[i % queensPerRow.size()] > 1 || queensPerD1[i] > 1 ||
-        queensPerD2[i] > 1) {
-      return true;
+// best_row over every row of `col`, scored by `counters` less 3 on the
+// queen's own `current` row. The counters are scanned by scan_rows_avx2 when
+// enabled; a minimum with a saturated counter in it is rescored exactly.
+template <typename Counters>
+int scan_best_row(int col, int current, Counters &counters,
+                  const index_pool &freeRows, const solve_options &options) {
+  const int n = counters.rows();
+
+  if (options.rows == row_mode::full && options.simd != simd_mode::off &&
+      has_avx2()) {
+    row_choice best = scan_rows_avx2(counters.row_data(), counters.d1_data(),
+                                     counters.d2_data(), n, col, current, 3,
+                                     random_below);
+
+    if (options.simd == simd_mode::check) {
+      row_choice scalar = scan_rows_scalar(
+          counters.row_data(), counters.d1_data(), counters.d2_data(), n, col,
+          current, 3, random_below);
+
+      if (scalar.conflicts != best.conflicts ||
+          scalar.conflicts != counters.conflicts(best.row, col) -
+                                  (best.row == current ? 3 : 0)) {
+        fprintf(stderr, "SIMD row scan mismatch in column %d\n", col);
+        abort();
+      }
+    }
+
+    if (best.conflicts < Counters::saturated - 3) {
+      return best.row;
     }
   }
 
-  return false;
+  return best_row(n, current, options, freeRows, [&](int row) {
+    return counters.conflicts(row, col) - (row == current ? 3 : 0);
+  });
 }
 
-void init(std::vector<int> &nQueens, std::vector<int> &queensPerRow,
-          std::vector<int> &queensPerD1, std::vector<int> &queensPerD2) {
-  const int n = nQueens.size();
-  const int dOffset = n - 1;
+template <typename Counters>
+void place_queen(int col, int row, std::vector<int> &nQueens,
+                 Counters &counters, index_pool &freeRows) {
+  nQueens[col] = row;
+  if (counters.place(row, col)) {
+    freeRows.erase(row);
+  }
+}
 
-  // horse distance
-  //
-  /* for (int row = 0, col = 1; row < n; row++) { */
-  /*   nQueens[col] = row; */
-  /*   queensPerRow[row]++; */
-  /*   queensPerD1[col - row + dOffset]++; */
-  /*   queensPerD2[col + row]++; */
+template <typename Counters>
+void init(std::vector<int> &nQueens, Counters &counters, index_pool &freeRows,
+          const solve_options &options) {
+  const int n = nQueens.size();
 
-  /*   col += 2; */
-  /*   if (col >= n) { */
-  /*     col = 0; */
-  /*   } */
-  /* } */
+  counters.reset(n);
+  freeRows.reset(n);
+  for (int row = 0; row < n; row++) {
+    freeRows.insert(row);
+  }
 
-  // greedy
+  // linear: a random free row has both diagonals free with constant
+  // probability until the board is nearly full, so every column takes O(1)
+  // expected tries; the columns where `tries` draws miss fall back to the
+  // best of the sampled free rows
 
-  nQueens[0] = mt() % n;
-  queensPerRow[nQueens[0]] = 1;
-  queensPerD1[-nQueens[0] + dOffset] = 1;
-  queensPerD2[nQueens[0]] = 1;
+  if (options.init == init_mode::linear) {
+    const int tries = 16;
+    solve_options fallback = options;
+    fallback.rows = row_mode::free;
 
-  for (int col = 1; col < n; col++) {
-    int minConflicts = INT32_MAX;
-    std::vector<int> rowList;
+    for (int col = 0; col < n; col++) {
+      int row = -1;
 
-    for (int row = 0; row < n; row++) {
-      int conflicts =
-          find_conflicts(n, row, col, queensPerRow, queensPerD1, queensPerD2);
+      for (int i = 0; i < tries && row == -1; i++) {
+        int candidate = freeRows.random(random_below);
 
-      if (minConflicts > conflicts) {
-        minConflicts = conflicts;
-        rowList.clear();
-        rowList.push_back(row);
+        if (!counters.d1(candidate, col) && !counters.d2(candidate, col)) {
+          row = candidate;
+        }
       }
-      if (minConflicts == conflicts) {
-        rowList.push_back(row);
+
+      if (row == -1) {
+        row = best_row(n, -1, fallback, freeRows, [&](int candidate) {
+          return counters.conflicts(candidate, col);
+        });
       }
+
+      place_queen(col, row, nQueens, counters, freeRows);
     }
 
-    nQueens[col] = rowList[mt() % rowList.size()];
-    queensPerRow[nQueens[col]]++;
-    queensPerD1[col - nQueens[col] + dOffset]++;
-    queensPerD2[col + nQueens[col]]++;
+    return;
+  }
+
+  // greedy
+
+  place_queen(0, random_below(n), nQueens, counters, freeRows);
+
+  for (int col = 1; col < n; col++) {
+    int row = scan_best_row(col, -1, counters, freeRows, options);
+
+    place_queen(col, row, nQueens, counters, freeRows);
+  }
+}
+
+// Queens on every row and diagonal as intrusive doubly linked lists, so a
+// move only has to visit the queens sharing a line with it. Lines are the
+// rows, then the D1 and then the D2 diagonals; links are per column and
+// line kind (row, D1, D2).
+struct queen_lines {
+  std::vector<int> head;
+  std::vector<int> next;
+  std::vector<int> prev;
+};
+
+void line_ids(int n, int row, int col, int ids[3]) {
+  const int dOffset = n - 1;
+
+  ids[0] = row;
+  ids[1] = n + col - row + dOffset;
+  ids[2] = 3 * n - 1 + col + row;
+}
+
+void link(queen_lines &lines, int col, int kind, int line) {
+  int at = col * 3 + kind;
+  int first = lines.head[line];
+
+  lines.prev[at] = -1;
+  lines.next[at] = first;
+  if (first != -1) {
+    lines.prev[first * 3 + kind] = col;
   }
+  lines.head[line] = col;
 }
 
-int col_max_conflicts(std::vector<int> &nQueens, std::vector<int> &queensPerRow,
-                      std::vector<int> &queensPerD1,
-                      std::vector<int> &queensPerD2) {
+void unlink(queen_lines &lines, int col, int kind, int line) {
+  int at = col * 3 + kind;
+
+  if (lines.prev[at] != -1) {
+    lines.next[lines.prev[at] * 3 + kind] = lines.next[at];
+  } else {
+    lines.head[line] = lines.next[at];
+  }
+  if (lines.next[at] != -1) {
+    lines.prev[lines.next[at] * 3 + kind] = lines.prev[at];
+  }
+}
+
+// Builds the lines and the per-column conflicts for a fresh placement.
+template <typename Counters>
+void track(std::vector<int> &nQueens, Counters &counters, queen_lines &lines,
+           conflict_buckets &buckets) {
   const int n = nQueens.size();
+  std::vector<int> conflicts(n);
 
-  int maxConflicts = 0;
-  std::vector<int> colList;
+  lines.head.assign(5 * n - 2, -1);
+  lines.next.resize(3 * n);
+  lines.prev.resize(3 * n);
 
   for (int col = 0; col < n; col++) {
-    int row = nQueens[col];
-    int conflicts =
-        find_conflicts(n, row, col, queensPerRow, queensPerD1, queensPerD2) - 3;
+    int ids[3];
+    line_ids(n, nQueens[col], col, ids);
 
-    if (maxConflicts < conflicts) {
-      maxConflicts = conflicts;
-      colList.clear();
-      colList.push_back(col);
-    } else if (maxConflicts == conflicts) {
-      colList.push_back(col);
+    for (int kind = 0; kind < 3; kind++) {
+      link(lines, col, kind, ids[kind]);
     }
-  }
 
-  if (maxConflicts == 0) {
-    return -1;
+    // every line counts the queen itself once
+    conflicts[col] = counters.conflicts(nQueens[col], col) - 3;
   }
 
-  return colList[mt() % colList.size()];
+  buckets.assign(conflicts);
 }
 
-int row_min_conflicts(int col, std::vector<int> &nQueens,
-                      std::vector<int> &queensPerRow,
-                      std::vector<int> &queensPerD1,
-                      std::vector<int> &queensPerD2) {
+template <typename Counters>
+void move_queen(int col, int row, std::vector<int> &nQueens,
+                Counters &counters, index_pool &freeRows, queen_lines &lines,
+                conflict_buckets &buckets) {
   const int n = nQueens.size();
-  const int dOffset = n - 1;
 
   int lastRow = nQueens[col];
-  std::vector<int> rowList;
 
-  queensPerRow[lastRow]--;
-  queensPerD1[col - lastRow + dOffset]--;
-  queensPerD2[col + lastRow]--;
+  if (row == lastRow) {
+    return;
+  }
 
-  int minConflicts =
-      find_conflicts(n, lastRow, col, queensPerRow, queensPerD1, queensPerD2);
+  int ids[3];
+  line_ids(n, lastRow, col, ids);
 
-  for (int row = 0; row < n; row++) {
-    int conflicts =
-        find_conflicts(n, row, col, queensPerRow, queensPerD1, queensPerD2);
+  for (int kind = 0; kind < 3; kind++) {
+    unlink(lines, col, kind, ids[kind]);
 
-    if (minConflicts > conflicts) {
-      minConflicts = conflicts;
-      rowList.clear();
-      rowList.push_back(row);
-    } else if (minConflicts == conflicts) {
-      rowList.push_back(row);
+    for (int q = lines.head[ids[kind]]; q != -1; q = lines.next[q * 3 + kind]) {
+      buckets.change(q, buckets.value(q) - 1);
     }
   }
 
-  int minRow = rowList[mt() % rowList.size()];
+  if (counters.remove(lastRow, col)) {
+    freeRows.insert(lastRow);
+  }
 
-  queensPerRow[minRow]++;
-  queensPerD1[col - minRow + dOffset]++;
-  queensPerD2[col + minRow]++;
+  line_ids(n, row, col, ids);
 
-  return minRow;
+  for (int kind = 0; kind < 3; kind++) {
+    for (int q = lines.head[ids[kind]]; q != -1; q = lines.next[q * 3 + kind]) {
+      buckets.change(q, buckets.value(q) + 1);
+    }
+
+    link(lines, col, kind, ids[kind]);
+  }
+
+  place_queen(col, row, nQueens, counters, freeRows);
+  buckets.change(col, counters.conflicts(row, col) - 3);
+}
+
+int col_max_conflicts(conflict_buckets &buckets) {
+  if (buckets.max() == 0) {
+    return -1;
+  }
+
+  return buckets.random_max(random_below);
+}
+
+// Best row for the queen in `col`, ignoring the queen itself. It only shares
+// lines with its own row, so every other row is scored as is.
+template <typename Counters>
+int row_min_conflicts(int col, std::vector<int> &nQueens, Counters &counters,
+                      index_pool &freeRows, const solve_options &options) {
+  return scan_best_row(col, nQueens[col], counters, freeRows, options);
 }
 
-bool solve(std::vector<int> &nQueens) {
+// The same search as a min_conflicts policy: a variable per column, whose
+// values are the rows.
+template <typename Counters> class queens_problem {
+public:
+  queens_problem(std::vector<int> &nQueens, const solve_options &options)
+      : _nQueens(nQueens), _options(options) {}
+
+  int variables() const { return _nQueens.size(); }
+  int value(int col) const { return _nQueens[col]; }
+  size_t counter_bytes() const { return _counters.bytes(); }
+  long long init_nanos() const { return _initNanos; }
+
+  template <typename Random> void init(Random &) {
+    auto start = std::chrono::steady_clock::now();
+    ::init(_nQueens, _counters, _freeRows, _options);
+    track(_nQueens, _counters, _lines, _buckets);
+    _initNanos += nanos_since(start);
+  }
+
+  template <typename Random> int conflicted(Random &random) {
+    return _buckets.max() ? _buckets.random_max(random) : -1;
+  }
+
+  template <typename Visit> void candidates(int col, Visit visit) {
+    int lastRow = _nQueens[col];
+
+    for_each_candidate_row(
+        variables(), lastRow, _options, _freeRows, [&](int row) {
+          visit(row, _counters.conflicts(row, col) - (row == lastRow ? 3 : 0));
+        });
+  }
+
+  // the dedicated loop's scan, AVX2 included
+  template <typename Random> int best_value(int col, Random &) {
+    return scan_best_row(col, _nQueens[col], _counters, _freeRows, _options);
+  }
+
+  template <typename Random> int random_value(int, Random &random) {
+    return random(variables());
+  }
+
+  void assign(int col, int row) {
+    move_queen(col, row, _nQueens, _counters, _freeRows, _lines, _buckets);
+  }
+
+private:
+  std::vector<int> &_nQueens;
+  const solve_options &_options;
+  Counters _counters;
+  queen_lines _lines;
+  conflict_buckets _buckets;
+  index_pool _freeRows;
+  long long _initNanos = 0;
+};
+
+// Explicit placement for every N but 2 and 3 (Hoffman, Loessi and Moore):
+// the even rows, then the odd rows (counting from 1), with a few rows moved
+// when N % 6 is 2 or 3. O(N) time and no memory beyond the board.
+bool construct(std::vector<int> &nQueens) {
+  const int n = nQueens.size();
+  int col = 0;
+
+  if (n == 2 || n == 3) {
+    return false;
+  }
+
+  auto put = [&](int row) { nQueens[col++] = row - 1; };
+
+  if (n % 6 == 3) {
+    // evens from 4, then 2; odds from 5, then 1 and 3
+    for (int row = 4; row <= n; row += 2) {
+      put(row);
+    }
+    put(2);
+    for (int row = 5; row <= n; row += 2) {
+      put(row);
+    }
+    put(1);
+    put(3);
+    return true;
+  }
+
+  for (int row = 2; row <= n; row += 2) {
+    put(row);
+  }
+
+  if (n % 6 == 2) {
+    // odds with 1 and 3 swapped and 5 moved to the end
+    put(3);
+    put(1);
+    for (int row = 7; row <= n; row += 2) {
+      put(row);
+    }
+    put(5);
+  } else {
+    for (int row = 1; row <= n; row += 2) {
+      put(row);
+    }
+  }
+
+  return true;
+}
+
+// Min-conflicts with restarts. Gives up and returns false once `stop` is
+// set.
+template <typename Counters>
+bool solve(std::vector<int> &nQueens, const solve_options &options,
+           const std::atomic<bool> &stop, solve_stats &stats) {
   int n = nQueens.size();
 
   if (n == 2 || n == 3) {
     return false;
   }
 
-  while (true) {
-    std::vector<int> queensPerRow(n);
-    std::vector<int> queensPerD1(2 * n - 1);
-    std::vector<int> queensPerD2(2 * n - 1);
+  if (options.engine == "construct") {
+    return construct(nQueens);
+  }
+
+  if (options.engine == "csp") {
+    queens_problem<Counters> problem(nQueens, options);
+    min_conflicts_options search;
+    min_conflicts_stats searchStats;
+
+    search.max_steps = 5 * (long long)n + 1;
+    search.walk = options.walk;
+    search.tabu = options.tabu;
+
+    auto start = std::chrono::steady_clock::now();
+    bool solved =
+        min_conflicts(problem, search, random_below, stop, searchStats);
+
+    stats.init_nanos += problem.init_nanos();
+    stats.repair_nanos += nanos_since(start) - problem.init_nanos();
+    stats.restarts += searchStats.restarts;
+    stats.iterations += searchStats.steps;
+    stats.counter_bytes = problem.counter_bytes();
+    return solved;
+  }
+
+  Counters counters;
+  queen_lines lines;
+  conflict_buckets buckets;
+  index_pool freeRows;
+
+  auto start = std::chrono::steady_clock::now();
 
-    init(nQueens, queensPerRow, queensPerD1, queensPerD2);
+  while (!stop.load(std::memory_order_relaxed)) {
+    auto initStart = std::chrono::steady_clock::now();
+    init(nQueens, counters, freeRows, options);
+    track(nQueens, counters, lines, buckets);
+    stats.init_nanos += nanos_since(initStart);
+    stats.restarts++;
+    stats.counter_bytes = counters.bytes();
+
+    auto repairStart = std::chrono::steady_clock::now();
     int iter = 0;
 
-    if (!has_conflicts(queensPerRow, queensPerD1, queensPerD2)) {
-      return true;
-    }
+    while (iter <= 5 * n && !stop.load(std::memory_order_relaxed)) {
+      if (!(iter & (iter - 1))) {
+        stats.trace.push_back({iter, nanos_since(start), buckets.total()});
+      }
 
-    while (iter++ <= 5 * n) {
-      int col =
-          col_max_conflicts(nQueens, queensPerRow, queensPerD1, queensPerD2);
+      int col = col_max_conflicts(buckets);
 
       if (col == -1) {
+        stats.repair_nanos += nanos_since(repairStart);
+        stats.trace.push_back({iter, nanos_since(start), 0});
         return true;
       }
 
-      int row = row_min_conflicts(col, nQueens, queensPerRow, queensPerD1,
-                                  queensPerD2);
+      int row = row_min_conflicts(col, nQueens, counters, freeRows, options);
 
-      nQueens[col] = row;
+      move_queen(col, row, nQueens, counters, freeRows, lines, buckets);
+      stats.iterations++;
+      iter++;
     }
+
+    stats.repair_nanos += nanos_since(repairStart);
+  }
+
+  return false;
+}
+
+// Races independent restarts on `threads` threads, each with its own board,
+// counters and seed, and keeps the first solution; the others are stopped.
+template <typename Counters>
+bool parallel_solve(std::vector<int> &nQueens, const solve_options &options,
+                    solve_stats &stats) {
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> workers;
+  std::vector<solve_stats> workerStats(options.threads);
+  const uint64_t seed = options.seed;
+
+  int winner = 0;
+
+  for (int worker = 0; worker < options.threads; worker++) {
+    workers.emplace_back([&, worker] {
+      std::vector<int> board(nQueens.size());
+
+      rng.seed(seed + worker);
+      if (solve<Counters>(board, options, stop, workerStats[worker]) &&
+          !stop.exchange(true)) {
+        nQueens = std::move(board);
+        winner = worker;
+      }
+    });
+  }
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  // times and the trace are the winner's, counts are summed
+  for (const auto &s : workerStats) {
+    stats.restarts += s.restarts;
+    stats.iterations += s.iterations;
+    stats.counter_bytes += s.counter_bytes;
+  }
+  stats.init_nanos = workerStats[winner].init_nanos;
+  stats.repair_nanos = workerStats[winner].repair_nanos;
+  stats.trace = std::move(workerStats[winner].trace);
+
+  return stop.load();
+}
+
+bool parallel_solve(std::vector<int> &nQueens, const solve_options &options,
+                    solve_stats &stats) {
+  switch (options.counter_bits) {
+  case 8:
+    return parallel_solve<line_counters<uint8_t>>(nQueens, options, stats);
+  case 16:
+    return parallel_solve<line_counters<uint16_t>>(nQueens, options, stats);
+  default:
+    return parallel_solve<line_counters<int32_t>>(nQueens, options, stats);
   }
 }
 
-int main() {
-  int n = 0;
+// Colors the DIMACS graph in `path` with min_conflicts and reports the
+// result; the colors go to `output` (one per line) if it is not empty.
+bool run_coloring(const std::string &path, int colors,
+                  const solve_options &options, const std::string &output) {
+  std::FILE *in = fopen(path.c_str(), "r");
+  if (!in) {
+    throw std::runtime_error("Could not open " + path);
+  }
+
+  graph_coloring problem = read_dimacs(in, colors);
+  fclose(in);
+
+  rng.seed(options.seed);
 
-  std::cin >> n;
+  min_conflicts_options search;
+  min_conflicts_stats stats;
+  std::atomic<bool> stop(false);
 
-  std::vector<int> nQueens(n);
+  search.max_steps = 100 * (long long)problem.variables() + 1000;
+  search.walk = options.walk;
+  search.tabu = options.tabu;
 
-  auto start = std::chrono::system_clock::now();
+  auto start = std::chrono::steady_clock::now();
 
-  bool result = solve(nQueens);
+  // a coloring may not exist
+  search.max_restarts = 10;
 
-  double total_millis = std::chrono::duration_cast<std::chrono::milliseconds>(
-                            std::chrono::system_clock::now() - start)
-                            .count();
+  bool solved =
+      min_conflicts(problem, search, random_below, stop, stats);
 
-  if (result) {
-    printf("\ntime: %.2f\n\n", total_millis / 1e3);
+  double millis = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
 
-    if (n <= 20) {
-      print_board(nQueens);
+  printf("%s\ntime: %.2f\nrestarts: %lld\nsteps: %lld\n",
+         solved ? "colored" : "No coloring found", millis / 1e3,
+         stats.restarts, stats.steps);
+
+  if (solved && !output.empty()) {
+    std::FILE *out = fopen(output.c_str(), "w");
+    if (!out) {
+      throw std::runtime_error("Could not open " + output);
     }
-  } else {
-    printf("No solution found\n");
+
+    {
+      buffered_writer writer(out);
+      for (int vertex = 0; vertex < problem.variables(); vertex++) {
+        writer.write_int(problem.value(vertex));
+        writer.put('\n');
+      }
+      writer.flush();
+    }
+    fclose(out);
+  }
+
+  return solved;
+}
+
+std::vector<int> parse_sizes(const std::string &sizes) {
+  std::vector<int> ns;
+
+  for (size_t at = 0; at < sizes.size();) {
+    size_t end = sizes.find(',', at);
+    if (end == std::string::npos) {
+      end = sizes.size();
+    }
+    ns.push_back(std::stoi(sizes.substr(at, end - at)));
+    if (ns.back() < 1) {
+      throw std::invalid_argument("N must be at least 1");
+    }
+    at = end + 1;
   }
 
-  pause();
+  return ns;
+}
+
+double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  size_t half = values.size() / 2;
+  return values.size() & 1 ? values[half]
+                           : (values[half - 1] + values[half]) / 2;
+}
+
+// Solves every N in the comma separated `sizes` `repeat` times with the
+// dedicated loop, min_conflicts and the construction, and writes a CSV line
+// per N and engine with the median wall time, its median absolute deviation
+// and the median number of iterations.
+void run_benchmark(const std::string &sizes, int repeat,
+                   solve_options options) {
+  std::vector<int> ns = parse_sizes(sizes);
+
+  printf("n,engine,millis,mad,iterations\n");
+
+  for (int n : ns) {
+    for (const char *engine : {"queens", "csp", "construct"}) {
+      std::vector<double> millis, iterations;
+
+      options.engine = engine;
+      for (int run = 0; run < repeat; run++) {
+        std::vector<int> nQueens(n);
+        solve_stats stats;
+        std::atomic<bool> stop(false);
+
+        rng.seed(options.seed + run);
+        auto start = std::chrono::steady_clock::now();
+        solve<line_counters<int32_t>>(nQueens, options, stop, stats);
+        millis.push_back(nanos_since(start) / 1e6);
+        iterations.push_back(stats.iterations);
+      }
+
+      double mid = median(millis);
+      std::vector<double> deviations;
+      for (double m : millis) {
+        deviations.push_back(std::abs(m - mid));
+      }
+
+      printf("%d,%s,%.3f,%.3f,%.0f\n", n, engine, mid, median(deviations),
+             median(iterations));
+      fflush(stdout);
+    }
+  }
+}
+
+// Solves every N in `sizes` `repeat` times with `options`, run r seeded
+// with seed + r, and writes a CSV line per run, so a slow run can be
+// replayed with its seed.
+void run_sweep(const std::string &sizes, int repeat, solve_options options) {
+  const uint64_t seed = options.seed;
+  std::vector<int> ns = parse_sizes(sizes);
+
+  printf("n,seed,restarts,iterations,init_ms,repair_ms,ns_per_iteration,"
+         "millis\n");
+
+  for (int n : ns) {
+    for (int run = 0; run < repeat; run++) {
+      std::vector<int> nQueens(n);
+      solve_stats stats;
+
+      options.seed = seed + run;
+      auto start = std::chrono::steady_clock::now();
+      bool solved = parallel_solve(nQueens, options, stats);
+      double millis = nanos_since(start) / 1e6;
+
+      if (!solved) {
+        continue;
+      }
+
+      printf("%d,%llu,%lld,%lld,%.3f,%.3f,%.1f,%.3f\n", n,
+             (unsigned long long)options.seed, stats.restarts,
+             stats.iterations, stats.init_nanos / 1e6,
+             stats.repair_nanos / 1e6,
+             double(stats.repair_nanos) / std::max(1ll, stats.iterations),
+             millis);
+      fflush(stdout);
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  solve_options options;
+  // solution output, see write_solution; empty prints the board for N <= 20
+  std::string format;
+  std::string output;
+  std::string verify;
+  std::string coloring;
+  int colors = 3;
+  std::string bench;
+  std::string sweep;
+  int repeat = 5;
+  bool trace = false;
+
+  options.seed = time(NULL);
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+
+    if (arg == "--init=greedy") {
+      options.init = init_mode::greedy;
+    } else if (arg == "--init=linear") {
+      options.init = init_mode::linear;
+    } else if (arg == "--rows=full") {
+      options.rows = row_mode::full;
+    } else if (arg == "--rows=sample") {
+      options.rows = row_mode::sample;
+    } else if (arg == "--rows=free") {
+      options.rows = row_mode::free;
+    } else if (arg.rfind("--samples=", 0) == 0) {
+      options.samples = std::max(1, std::stoi(arg.substr(10)));
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      // 0 uses every hardware thread
+      options.threads = std::max(0, std::stoi(arg.substr(10)));
+      if (options.threads == 0) {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+    } else if (arg == "--counters=8" || arg == "--counters=16" ||
+               arg == "--counters=32") {
+      options.counter_bits = std::stoi(arg.substr(11));
+    } else if (arg == "--format=board" || arg == "--format=text" ||
+               arg == "--format=binary") {
+      format = arg.substr(9);
+    } else if (arg.rfind("--output=", 0) == 0) {
+      output = arg.substr(9);
+    } else if (arg.rfind("--verify=", 0) == 0) {
+      // checks a written solution instead of solving
+      verify = arg.substr(9);
+    } else if (arg == "--engine=queens" || arg == "--engine=csp" ||
+               arg == "--engine=construct") {
+      options.engine = arg.substr(9);
+    } else if (arg.rfind("--walk=", 0) == 0) {
+      options.walk = std::stod(arg.substr(7));
+    } else if (arg.rfind("--tabu=", 0) == 0) {
+      options.tabu = std::max(0, std::stoi(arg.substr(7)));
+    } else if (arg.rfind("--coloring=", 0) == 0) {
+      // colors a DIMACS graph instead of placing queens
+      coloring = arg.substr(11);
+    } else if (arg.rfind("--colors=", 0) == 0) {
+      colors = std::stoi(arg.substr(9));
+    } else if (arg == "--simd=auto") {
+      options.simd = simd_mode::detect;
+    } else if (arg == "--simd=off") {
+      options.simd = simd_mode::off;
+    } else if (arg == "--simd=check") {
+      options.simd = simd_mode::check;
+    } else if (arg.rfind("--bench=", 0) == 0) {
+      bench = arg.substr(8);
+    } else if (arg.rfind("--seed=", 0) == 0) {
+      options.seed = std::stoull(arg.substr(7));
+    } else if (arg == "--trace") {
+      trace = true;
+    } else if (arg == "--sweep") {
+      sweep = "1000,10000,100000,1000000,10000000";
+    } else if (arg.rfind("--sweep=", 0) == 0) {
+      sweep = arg.substr(8);
+    } else if (arg.rfind("--repeat=", 0) == 0) {
+      repeat = std::max(1, std::stoi(arg.substr(9)));
+    } else {
+      std::cout << "Unknown option " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  try {
+    if (!coloring.empty()) {
+      return run_coloring(coloring, colors, options, output) ? 0 : 2;
+    }
+
+    if (!bench.empty()) {
+      run_benchmark(bench, repeat, options);
+      return 0;
+    }
+
+    if (!sweep.empty()) {
+      run_sweep(sweep, repeat, options);
+      return 0;
+    }
+
+    if (!verify.empty()) {
+      std::FILE *in = fopen(verify.c_str(), "rb");
+      if (!in) {
+        throw std::runtime_error("Could not open " + verify);
+      }
+
+      std::vector<int> nQueens =
+          read_solution(in, format.empty() ? "text" : format);
+      fclose(in);
+
+      bool valid = verify_solution(nQueens);
+      printf("%s (N = %zu)\n", valid ? "valid" : "invalid", nQueens.size());
+      return valid ? 0 : 2;
+    }
+
+    int n = 0;
+
+    std::cin >> n;
+
+    if (n < 1) {
+      throw std::invalid_argument("N must be at least 1");
+    }
+
+    std::vector<int> nQueens(n);
+    solve_stats stats;
+    cache_miss_counter misses;
+
+    auto start = std::chrono::steady_clock::now();
+
+    bool result = parallel_solve(nQueens, options, stats);
+
+    double total_millis = nanos_since(start) / 1e6;
+
+    // a solution written to stdout keeps it clean of the report
+    bool toStdout = !format.empty() && output.empty();
+    std::FILE *report = toStdout ? stderr : stdout;
+
+    if (result) {
+      fprintf(report, "\ntime: %.6f\n", total_millis / 1e3);
+      fprintf(report, "seed: %llu\n", (unsigned long long)options.seed);
+      fprintf(report, "restarts: %lld\niterations: %lld\n", stats.restarts,
+              stats.iterations);
+      fprintf(report,
+              "init: %.3f ms\nrepair: %.3f ms (%.1f ns per iteration)\n",
+              stats.init_nanos / 1e6, stats.repair_nanos / 1e6,
+              double(stats.repair_nanos) / std::max(1ll, stats.iterations));
+      fprintf(report, "counters: %.1f MB\npeak rss: %.1f MB\n",
+              stats.counter_bytes / 1048576.0, peak_rss() / 1048576.0);
+      if (misses.available()) {
+        long long count = misses.read();
+        fprintf(report, "cache misses: %lld (%.1f per iteration)\n", count,
+                double(count) / std::max(1ll, stats.iterations));
+      } else {
+        fprintf(report, "cache misses: unavailable\n");
+      }
+      if (trace) {
+        fprintf(report, "trace (iteration,ns,conflicts):\n");
+        for (const trace_point &point : stats.trace) {
+          fprintf(report, "%lld,%lld,%lld\n", point.iteration, point.nanos,
+                  point.conflicts);
+        }
+      }
+      fprintf(report, "\n");
+      fflush(report);
+
+      if (!format.empty()) {
+        std::FILE *out =
+            output.empty() ? stdout : fopen(output.c_str(), "wb");
+        if (!out) {
+          throw std::runtime_error("Could not open " + output);
+        }
+
+        {
+          buffered_writer writer(out);
+          write_solution(writer, nQueens, format);
+          writer.flush();
+        }
+
+        if (out != stdout) {
+          fclose(out);
+        }
+      } else if (n <= 20) {
+        buffered_writer writer(stdout);
+        write_solution(writer, nQueens, "board");
+        writer.flush();
+      }
+    } else {
+      fprintf(report, "No solution found\n");
+    }
+
+    if (!toStdout) {
+      pause();
+    }
+  } catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
 
   return 0;
 }
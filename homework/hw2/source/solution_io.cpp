@@ -0,0 +1,152 @@
+#include "solution_io.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+
+buffered_writer::buffered_writer(std::FILE *file, size_t capacity)
+    : _file(file), _buffer(capacity) {}
+
+buffered_writer::~buffered_writer() {
+  // errors are only reported by an explicit flush()
+  if (_size) {
+    fwrite(_buffer.data(), 1, _size, _file);
+  }
+  fflush(_file);
+}
+
+void buffered_writer::write(const char *data, size_t size) {
+  if (_size + size > _buffer.size()) {
+    flush();
+  }
+
+  if (size >= _buffer.size()) {
+    if (fwrite(data, 1, size, _file) != size) {
+      throw std::runtime_error("Could not write the solution.");
+    }
+    return;
+  }
+
+  std::copy(data, data + size, _buffer.data() + _size);
+  _size += size;
+}
+
+void buffered_writer::write_int(long long value) {
+  char digits[24];
+  auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+  (void)error;
+  write(digits, end - digits);
+}
+
+void buffered_writer::flush() {
+  if (_size && fwrite(_buffer.data(), 1, _size, _file) != _size) {
+    throw std::runtime_error("Could not write the solution.");
+  }
+  _size = 0;
+  if (fflush(_file)) {
+    throw std::runtime_error("Could not write the solution.");
+  }
+}
+
+void write_solution(buffered_writer &out, const std::vector<int> &nQueens,
+                    const std::string &format) {
+  const int n = nQueens.size();
+
+  if (format == "text") {
+    out.write_int(n);
+    out.put('\n');
+    for (int row : nQueens) {
+      out.write_int(row);
+      out.put('\n');
+    }
+  } else if (format == "binary") {
+    uint32_t value = n;
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    for (int row : nQueens) {
+      value = row;
+      out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+  } else if (format == "board") {
+    // the column of the queen on every row
+    std::vector<int> queenCol(n);
+    std::vector<char> line(2 * n + 1);
+
+    for (int col = 0; col < n; col++) {
+      queenCol[nQueens[col]] = col;
+    }
+
+    for (int col = 0; col < n; col++) {
+      line[2 * col] = '_';
+      line[2 * col + 1] = ' ';
+    }
+    line[2 * n] = '\n';
+
+    for (int row = 0; row < n; row++) {
+      line[2 * queenCol[row]] = '*';
+      out.write(line.data(), line.size());
+      line[2 * queenCol[row]] = '_';
+    }
+    out.put('\n');
+  } else {
+    throw std::invalid_argument("Unknown solution format " + format);
+  }
+}
+
+// The header's N is not trusted for allocation: rows are stored as they
+// arrive, at most this many ahead, so a truncated or corrupt file fails as
+// invalid instead of reserving memory for N rows that are not there.
+static const size_t read_chunk = 1 << 16;
+
+std::vector<int> read_solution(std::FILE *in, const std::string &format) {
+  std::vector<int> nQueens;
+
+  if (format == "text") {
+    long long n = -1;
+    if (fscanf(in, "%lld", &n) != 1 || n < 0 || n > INT32_MAX) {
+      throw std::runtime_error("Invalid solution (no size)");
+    }
+
+    nQueens.reserve(std::min<size_t>(n, read_chunk));
+    for (int row; int(nQueens.size()) < n; nQueens.push_back(row)) {
+      if (fscanf(in, "%d", &row) != 1) {
+        throw std::runtime_error("Invalid solution (too few rows)");
+      }
+    }
+  } else if (format == "binary") {
+    uint32_t n = 0;
+    if (fread(&n, sizeof(n), 1, in) != 1 || n > INT32_MAX) {
+      throw std::runtime_error("Invalid solution (no size)");
+    }
+
+    std::vector<uint32_t> rows(std::min<size_t>(n, read_chunk));
+    while (nQueens.size() < n) {
+      size_t count = std::min<size_t>(n - nQueens.size(), rows.size());
+      if (fread(rows.data(), sizeof(uint32_t), count, in) != count) {
+        throw std::runtime_error("Invalid solution (too few rows)");
+      }
+      nQueens.insert(nQueens.end(), rows.begin(), rows.begin() + count);
+    }
+  } else {
+    throw std::invalid_argument("Cannot read solution format " + format);
+  }
+
+  return nQueens;
+}
+
+bool verify_solution(const std::vector<int> &nQueens) {
+  const int n = nQueens.size();
+  std::vector<bool> rows(n), d1(2 * n), d2(2 * n);
+
+  for (int col = 0; col < n; col++) {
+    int row = nQueens[col];
+
+    if (row < 0 || row >= n || rows[row] || d1[col - row + n] ||
+        d2[col + row]) {
+      return false;
+    }
+    rows[row] = d1[col - row + n] = d2[col + row] = true;
+  }
+
+  return true;
+}
@@ -0,0 +1,67 @@
+#include "telemetry.hpp"
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2 // the kernel32 entry point, no psapi.lib needed
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+size_t peak_rss() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS info;
+  bool known = GetProcessMemoryInfo(GetCurrentProcess(), &info, sizeof(info));
+  return known ? info.PeakWorkingSetSize : 0;
+#else
+  // ru_maxrss is in bytes on macOS and in kilobytes elsewhere
+  struct rusage usage;
+  bool known = getrusage(RUSAGE_SELF, &usage) == 0;
+#if defined(__APPLE__)
+  size_t unit = 1;
+#else
+  size_t unit = 1024;
+#endif
+  return known ? size_t(usage.ru_maxrss) * unit : 0;
+#endif
+}
+
+cache_miss_counter::cache_miss_counter() {
+#ifdef __linux__
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.inherit = 1;
+
+  _fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+cache_miss_counter::~cache_miss_counter() {
+#ifdef __linux__
+  if (_fd != -1) {
+    close(_fd);
+  }
+#endif
+}
+
+long long cache_miss_counter::read() const {
+#ifdef __linux__
+  long long count = 0;
+  if (_fd != -1 && ::read(_fd, &count, sizeof(count)) == sizeof(count)) {
+    return count;
+  }
+#endif
+  return -1;
+}
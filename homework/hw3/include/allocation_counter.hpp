@@ -0,0 +1,10 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+// Built with -DCOUNT_ALLOCATIONS (./makeMe.sh check), operator new is
+// replaced by one that counts, and this returns the heap allocations made
+// by any thread since the program started. Otherwise the default allocator
+// is kept and this returns -1.
+long long heap_allocations();
+
+#endif
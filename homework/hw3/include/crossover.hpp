@@ -0,0 +1,64 @@
+#ifndef CROSSOVER_HPP
+#define CROSSOVER_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "distance_table.hpp"
+#include "neighbor_lists.hpp"
+
+// Permutation crossovers in O(n) (EAX: O(n) plus the subtour merges). They
+// read two parent paths and write a child path of the same length into a
+// caller-owned buffer; all scratch memory lives in a crossover_workspace,
+// which is reused between calls.
+
+enum class crossover_kind { ox, pmx, eax };
+
+crossover_kind parse_crossover(const std::string &name);
+
+struct crossover_workspace {
+  void resize(int n);
+
+  // Marks are current while their stamp is; a new stamp clears all of them.
+  void clear_marks();
+  void mark(int value) { marks[value] = stamp; }
+  bool marked(int value) const { return marks[value] == stamp; }
+
+  std::vector<uint32_t> marks;
+  uint32_t stamp = 0;
+
+  // PMX: the p2 value at the p1 value's position in the section
+  std::vector<int> map;
+
+  // EAX, see edge_assembly_crossover; adjacencies have two slots per city
+  std::vector<int> adj_a, adj_b, rem_a, rem_b, adj_child;
+  std::vector<int> walk, even_at, even_prev;
+  std::vector<int> cycles, cycle_start;
+  std::vector<int> subtour, subtour_size, subtour_at, members;
+};
+
+// Order crossover (OX): the child keeps p1[a..b] in place and takes the
+// remaining cities in p2's order, starting after b.
+void order_crossover(const int *p1, const int *p2, int *child, int n, int a,
+                     int b, crossover_workspace &ws);
+
+// Partially mapped crossover (PMX): the child keeps p1[a..b] in place and
+// p2 everywhere else, with the cities of the section mapped through it.
+void partially_mapped_crossover(const int *p1, const int *p2, int *child,
+                                int n, int a, int b, crossover_workspace &ws);
+
+// Edge assembly crossover (EAX, single random AB-cycle). The parents are
+// read as closed tours: the child starts as `a`, one AB-cycle (alternating
+// edges of `a` and `b` found in the union of both) swaps some of a's edges
+// for b's, the resulting subtours are greedily merged with the cheapest
+// 2-opt reconnection, and the tour is opened at its longest edge. With
+// `near` a merge only looks at the neighbours of the subtour's cities, and
+// at every city only if none of those lies outside it.
+void edge_assembly_crossover(const int *a, const int *b, int *child, int n,
+                             const distance_table<double> &distances,
+                             crossover_workspace &ws, std::mt19937 &mt,
+                             const neighbor_lists *near = nullptr);
+
+#endif
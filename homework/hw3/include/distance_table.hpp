@@ -0,0 +1,71 @@
+#ifndef DISTANCE_TABLE_HPP
+#define DISTANCE_TABLE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Euclidean distances between n points. Coordinates are kept as separate x
+// and y arrays; when the full row-major n x n matrix of `Real` fits in
+// `matrix_budget` bytes it is precomputed, otherwise every distance is
+// computed from the coordinates, which beats a matrix that misses the cache
+// on every lookup.
+template <typename Real> class distance_table {
+public:
+  // about the size of a per-core L2 cache
+  static constexpr size_t default_budget = size_t(2) << 20;
+
+  distance_table() = default;
+
+  distance_table(const std::vector<double> &xs, const std::vector<double> &ys,
+                 size_t matrix_budget = default_budget)
+      : _n(xs.size()), _xs(xs), _ys(ys) {
+    if (_n * _n * sizeof(Real) <= matrix_budget) {
+      _matrix.resize(_n * _n);
+
+      for (size_t i = 0; i < _n; i++) {
+        _matrix[i * _n + i] = 0;
+        for (size_t j = 0; j < i; j++) {
+          _matrix[i * _n + j] = _matrix[j * _n + i] = compute(i, j);
+        }
+      }
+    }
+  }
+
+  size_t size() const { return _n; }
+  bool precomputed() const { return !_matrix.empty(); }
+
+  Real operator()(int a, int b) const {
+    return precomputed() ? _matrix[a * _n + b] : compute(a, b);
+  }
+
+  // Length of the open path through `path[0..n)`, summed in double.
+  double path_length(const int *path, size_t n) const {
+    double sum = 0;
+
+    if (precomputed()) {
+      for (size_t i = 1; i < n; i++) {
+        sum += _matrix[path[i - 1] * _n + path[i]];
+      }
+    } else {
+      for (size_t i = 1; i < n; i++) {
+        sum += compute(path[i - 1], path[i]);
+      }
+    }
+
+    return sum;
+  }
+
+private:
+  size_t _n = 0;
+  std::vector<double> _xs;
+  std::vector<double> _ys;
+  std::vector<Real> _matrix;
+
+  Real compute(int a, int b) const {
+    double dx = _xs[a] - _xs[b], dy = _ys[a] - _ys[b];
+    return std::sqrt(dx * dx + dy * dy);
+  }
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef GENOME_ARENA_HPP
+#define GENOME_ARENA_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Paths of n towns for `capacity` genomes in one contiguous block, genome i
+// at path(i)[0..n), and their lengths in a parallel array. Sized once per
+// run; a generation only overwrites slots.
+class genome_arena {
+public:
+  void reset(int n, int capacity) {
+    _n = n;
+    _capacity = capacity;
+    _paths.assign(size_t(n) * capacity, 0);
+    _fitness.assign(capacity, INFINITY);
+  }
+
+  int n() const { return _n; }
+  int capacity() const { return _capacity; }
+
+  int *path(int i) { return _paths.data() + size_t(i) * _n; }
+  const int *path(int i) const { return _paths.data() + size_t(i) * _n; }
+
+  double &fitness(int i) { return _fitness[i]; }
+  double fitness(int i) const { return _fitness[i]; }
+
+  // Copies genome `i` of `from` into slot `to`.
+  void copy(int to, const genome_arena &from, int i) {
+    std::copy(from.path(i), from.path(i) + _n, path(to));
+    _fitness[to] = from._fitness[i];
+  }
+
+private:
+  int _n = 0;
+  int _capacity = 0;
+  std::vector<int> _paths;
+  std::vector<double> _fitness;
+};
+
+#endif
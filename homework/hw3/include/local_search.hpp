@@ -0,0 +1,64 @@
+#ifndef LOCAL_SEARCH_HPP
+#define LOCAL_SEARCH_HPP
+
+#include <chrono>
+#include <vector>
+
+#include "distance_table.hpp"
+#include "neighbor_lists.hpp"
+
+// 2-opt and Or-opt (segments of up to three cities) on an open path, tried
+// only towards each city's nearest neighbours and driven by don't-look
+// bits: a queue holds the cities whose surroundings changed, so after the
+// first pass the work follows the improvements instead of the path length.
+//
+// The open path is searched as a closed tour through an extra city (index
+// n) that is at distance 0 from everything; where it sits, the path ends.
+// Moves reverse whichever side of the tour is shorter.
+class local_search {
+public:
+  using clock = std::chrono::steady_clock;
+
+  local_search() = default;
+  local_search(const distance_table<double> &distances,
+               const neighbor_lists &near);
+
+  // Improves `path[0..n)` in place until no move gains or `deadline` passes
+  // and returns how much shorter the path got.
+  double improve(int *path, clock::time_point deadline);
+
+  long long moves() const { return _moves; }
+
+private:
+  const distance_table<double> *_distances = nullptr;
+  const neighbor_lists *_near = nullptr;
+  int _n = 0;
+  long long _moves = 0;
+
+  std::vector<int> _tour, _pos;
+  std::vector<int> _queue;
+  std::vector<char> _queued;
+  size_t _head = 0;
+
+  double cost(int a, int b) const {
+    return a == _n || b == _n ? 0 : (*_distances)(a, b);
+  }
+
+  int succ(int city) const {
+    int at = _pos[city] + 1;
+    return _tour[at == int(_tour.size()) ? 0 : at];
+  }
+
+  int pred(int city) const {
+    int at = _pos[city];
+    return _tour[at == 0 ? _tour.size() - 1 : at - 1];
+  }
+
+  void push(int city);
+  void reverse(int from, int to);
+  void exchange(int a, int b, int c, int d);
+  bool try_two_opt(int t1);
+  bool try_or_opt(int t1);
+};
+
+#endif
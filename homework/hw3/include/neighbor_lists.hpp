@@ -0,0 +1,27 @@
+#ifndef NEIGHBOR_LISTS_HPP
+#define NEIGHBOR_LISTS_HPP
+
+#include <vector>
+
+// The k nearest other cities of every city, nearest first. They are found
+// through a uniform grid of about two cities per cell, searched in growing
+// rings around the city's cell until no unseen cell can hold a closer one,
+// which takes about O(k) per city on evenly spread cities.
+class neighbor_lists {
+public:
+  neighbor_lists() = default;
+  neighbor_lists(const std::vector<double> &xs, const std::vector<double> &ys,
+                 int k);
+
+  int size() const { return _n; }
+  int k() const { return _k; }
+
+  const int *of(int city) const { return _near.data() + city * _k; }
+
+private:
+  int _n = 0;
+  int _k = 0;
+  std::vector<int> _near;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads that run one task at a time together: run(task)
+// calls task(worker) once for every worker 0..size()-1, worker 0 being the
+// calling thread, and returns when all of them are done. Workers sleep
+// between tasks, so the threads are started once and reused every call.
+class thread_pool {
+public:
+  explicit thread_pool(int threads) : _size(threads < 1 ? 1 : threads) {
+    for (int worker = 1; worker < _size; worker++) {
+      _threads.emplace_back([this, worker] { work(worker); });
+    }
+  }
+
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+      _round++;
+    }
+    _wake.notify_all();
+
+    for (auto &thread : _threads) {
+      thread.join();
+    }
+  }
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  int size() const { return _size; }
+
+  void run(const std::function<void(int)> &task) {
+    if (_size == 1) {
+      task(0);
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _task = &task;
+      _pending = _size - 1;
+      _round++;
+    }
+    _wake.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _pending == 0; });
+    _task = nullptr;
+  }
+
+private:
+  int _size;
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _done;
+  const std::function<void(int)> *_task = nullptr;
+  long long _round = 0;
+  int _pending = 0;
+  bool _stopping = false;
+
+  void work(int worker) {
+    long long seen = 0;
+
+    while (true) {
+      const std::function<void(int)> *task;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock, [&] { return _round != seen; });
+        seen = _round;
+        if (_stopping) {
+          return;
+        }
+        task = _task;
+      }
+
+      (*task)(worker);
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending--;
+      }
+      _done.notify_one();
+    }
+  }
+};
+
+#endif
@@ -31,9 +31,16 @@ FLAGS="-O2\
     -pedantic\
     -Wextra\
     --std=c++17\
+    -pthread\
     -I "./include"\
     "
 
+# "check" builds a separate binary that counts heap allocations
+if [[ $1 =~ check ]]; then
+    OUT="${OUT%.exe}-check.exe"
+    FLAGS="$FLAGS -DCOUNT_ALLOCATIONS"
+fi
+
 SRC="$(find "source/" -name "*.cpp")"
 
 if [ ! -d target/ ]; then
@@ -0,0 +1,35 @@
+#include "allocation_counter.hpp"
+
+#ifdef COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<long long> allocations{0};
+
+} // namespace
+
+long long heap_allocations() { return allocations.load(); }
+
+// in their own translation unit, so the compiler never sees malloc and free
+// across them
+void *operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+#else
+
+long long heap_allocations() { return -1; }
+
+#endif
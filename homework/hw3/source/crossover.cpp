@@ -0,0 +1,362 @@
+#include "crossover.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <stdexcept>
+
+crossover_kind parse_crossover(const std::string &name) {
+  if (name == "ox") {
+    return crossover_kind::ox;
+  }
+  if (name == "pmx") {
+    return crossover_kind::pmx;
+  }
+  if (name == "eax") {
+    return crossover_kind::eax;
+  }
+  throw std::invalid_argument("Unknown crossover " + name);
+}
+
+void crossover_workspace::resize(int n) {
+  if (int(marks.size()) != n) {
+    marks.assign(n, 0);
+    stamp = 0;
+    map.resize(n);
+
+    // EAX scratch at its largest, so that no call grows it: every edge is
+    // walked at most once and subtours have at least three cities
+    for (auto *list : {&walk, &even_prev, &cycles}) {
+      list->reserve(2 * n + 1);
+    }
+    for (auto *list : {&cycle_start, &members, &subtour_size, &subtour_at}) {
+      list->reserve(n + 1);
+    }
+  }
+}
+
+void crossover_workspace::clear_marks() {
+  if (++stamp == 0) {
+    std::fill(marks.begin(), marks.end(), 0);
+    stamp = 1;
+  }
+}
+
+void order_crossover(const int *p1, const int *p2, int *child, int n, int a,
+                     int b, crossover_workspace &ws) {
+  ws.clear_marks();
+
+  for (int i = a; i <= b; i++) {
+    child[i] = p1[i];
+    ws.mark(p1[i]);
+  }
+
+  int at = b + 1 == n ? 0 : b + 1;
+  for (int i = b + 1, left = n; left > 0; i++, left--) {
+    int city = p2[i >= n ? i - n : i];
+
+    if (!ws.marked(city)) {
+      child[at] = city;
+      at = at + 1 == n ? 0 : at + 1;
+    }
+  }
+}
+
+void partially_mapped_crossover(const int *p1, const int *p2, int *child,
+                                int n, int a, int b, crossover_workspace &ws) {
+  ws.clear_marks();
+
+  for (int i = a; i <= b; i++) {
+    child[i] = p1[i];
+    ws.mark(p1[i]);
+    ws.map[p1[i]] = p2[i];
+  }
+
+  // the map is injective, so the chains never share a city and all of them
+  // together take O(n)
+  for (int i = 0; i < n; i++) {
+    if (i == a) {
+      i = b;
+      continue;
+    }
+
+    int city = p2[i];
+    while (ws.marked(city)) {
+      city = ws.map[city];
+    }
+    child[i] = city;
+  }
+}
+
+namespace {
+
+// Both neighbours of every city on the closed tour `path`.
+void tour_adjacency(const int *path, int n, std::vector<int> &adj) {
+  adj.resize(2 * n);
+
+  for (int i = 0; i < n; i++) {
+    adj[2 * path[i]] = path[i == 0 ? n - 1 : i - 1];
+    adj[2 * path[i] + 1] = path[i + 1 == n ? 0 : i + 1];
+  }
+}
+
+// Replaces `from` with `to` in one of the two slots of `city`.
+void relink(std::vector<int> &adj, int city, int from, int to) {
+  adj[2 * city + (adj[2 * city] == from ? 0 : 1)] = to;
+}
+
+// A remaining edge at `city` drawn at random (-1 if there is none), which is
+// then removed from both ends.
+int take_edge(std::vector<int> &rem, int city, std::mt19937 &mt) {
+  int first = rem[2 * city], second = rem[2 * city + 1];
+  int slot;
+
+  if (first == -1 && second == -1) {
+    return -1;
+  } else if (first == -1) {
+    slot = 1;
+  } else if (second == -1) {
+    slot = 0;
+  } else {
+    slot = mt() & 1;
+  }
+
+  int other = rem[2 * city + slot];
+  rem[2 * city + slot] = -1;
+  rem[2 * other + (rem[2 * other] == city ? 0 : 1)] = -1;
+
+  return other;
+}
+
+} // namespace
+
+void edge_assembly_crossover(const int *a, const int *b, int *child, int n,
+                             const distance_table<double> &distances,
+                             crossover_workspace &ws, std::mt19937 &mt,
+                             const neighbor_lists *near) {
+  if (n < 5) {
+    std::copy(a, a + n, child);
+    return;
+  }
+
+  tour_adjacency(a, n, ws.adj_a);
+  tour_adjacency(b, n, ws.adj_b);
+
+  // edges of both tours take no part in AB-cycles
+  ws.rem_a = ws.adj_a;
+  ws.rem_b = ws.adj_b;
+  int start_count = 0;
+
+  for (int city = 0; city < n; city++) {
+    for (int slot = 0; slot < 2; slot++) {
+      int other = ws.adj_a[2 * city + slot];
+
+      if (ws.adj_b[2 * city] == other || ws.adj_b[2 * city + 1] == other) {
+        ws.rem_a[2 * city + slot] = -1;
+        ws.rem_b[2 * city + (ws.adj_b[2 * city] == other ? 0 : 1)] = -1;
+      }
+    }
+    start_count += ws.rem_a[2 * city] != -1 || ws.rem_a[2 * city + 1] != -1;
+  }
+
+  if (!start_count) {
+    std::copy(a, a + n, child);
+    return;
+  }
+
+  // A random city with an edge of `a` only starts a walk that alternates
+  // edges of `a` (leaving even positions) and `b` (leaving odd ones). Every
+  // city keeps as many remaining edges of one tour as of the other, so the
+  // walk can always go on, and it ends back at the start. Whenever it comes
+  // back by an edge of `b` to a city it left by an edge of `a`, the part in
+  // between is an AB-cycle and is cut off.
+  int start = mt() % n;
+  while (ws.rem_a[2 * start] == -1 && ws.rem_a[2 * start + 1] == -1) {
+    start = start + 1 == n ? 0 : start + 1;
+  }
+
+  ws.walk.assign(1, start);
+  ws.even_at.assign(n, -1);
+  ws.even_prev.clear();
+  ws.even_prev.push_back(-1);
+  ws.even_at[start] = 0;
+  ws.cycles.clear();
+  ws.cycle_start.clear();
+
+  while (true) {
+    int at = ws.walk.size() - 1;
+    int city = ws.walk.back();
+
+    if (!(at & 1)) {
+      int next = take_edge(ws.rem_a, city, mt);
+
+      if (next == -1) {
+        // only the start can run out, after its last cycle
+        break;
+      }
+
+      ws.walk.push_back(next);
+      ws.even_prev.push_back(-1);
+      continue;
+    }
+
+    int next = take_edge(ws.rem_b, city, mt);
+    int back = ws.even_at[next];
+
+    if (back == -1) {
+      ws.even_at[next] = ws.walk.size();
+      ws.even_prev.push_back(back);
+      ws.walk.push_back(next);
+      continue;
+    }
+
+    ws.cycle_start.push_back(ws.cycles.size());
+    ws.cycles.insert(ws.cycles.end(), ws.walk.begin() + back, ws.walk.end());
+
+    for (int i = ws.walk.size() - 1; i > back; i--) {
+      if (!(i & 1)) {
+        ws.even_at[ws.walk[i]] = ws.even_prev[i];
+      }
+    }
+    ws.walk.resize(back + 1);
+    ws.even_prev.resize(back + 1);
+  }
+  ws.cycle_start.push_back(ws.cycles.size());
+
+  // apply one AB-cycle to `a`: its even edges leave, its odd ones come in
+  int chosen = mt() % (ws.cycle_start.size() - 1);
+  int from = ws.cycle_start[chosen], to = ws.cycle_start[chosen + 1];
+  std::vector<int> &adj = ws.adj_child;
+
+  adj = ws.adj_a;
+  for (int i = from; i < to; i += 2) {
+    int u = ws.cycles[i], v = ws.cycles[i + 1];
+    relink(adj, u, v, -1);
+    relink(adj, v, u, -1);
+  }
+  for (int i = from + 1; i < to; i += 2) {
+    int u = ws.cycles[i], v = ws.cycles[i + 1 == to ? from : i + 1];
+    relink(adj, u, -1, v);
+    relink(adj, v, -1, u);
+  }
+
+  // label the subtours
+  ws.subtour.assign(n, -1);
+  ws.subtour_size.clear();
+  ws.subtour_at.clear();
+
+  for (int city = 0; city < n; city++) {
+    if (ws.subtour[city] != -1) {
+      continue;
+    }
+
+    int id = ws.subtour_size.size(), size = 0;
+    for (int prev = -1, at = city; ws.subtour[at] == -1;) {
+      int next = adj[2 * at] != prev ? adj[2 * at] : adj[2 * at + 1];
+      ws.subtour[at] = id;
+      size++;
+      prev = at;
+      at = next;
+    }
+
+    ws.subtour_size.push_back(size);
+    ws.subtour_at.push_back(city);
+  }
+
+  // merge the smallest subtour into another until one is left, each time
+  // with the cheapest exchange of one edge of each
+  for (int left = ws.subtour_size.size(); left > 1; left--) {
+    int smallest = -1;
+    for (int id = 0; id < int(ws.subtour_size.size()); id++) {
+      if (ws.subtour_size[id] &&
+          (smallest == -1 ||
+           ws.subtour_size[id] < ws.subtour_size[smallest])) {
+        smallest = id;
+      }
+    }
+
+    ws.members.clear();
+    for (int prev = -1, at = ws.subtour_at[smallest];
+         int(ws.members.size()) < ws.subtour_size[smallest];) {
+      int next = adj[2 * at] != prev ? adj[2 * at] : adj[2 * at + 1];
+      ws.members.push_back(at);
+      prev = at;
+      at = next;
+    }
+
+    double best = DBL_MAX;
+    int best_u1 = -1, best_u2 = -1, best_v1 = -1, best_v2 = -1;
+
+    auto consider = [&](int u1, int v1) {
+      if (ws.subtour[v1] == smallest) {
+        return;
+      }
+
+      double join = distances(u1, v1);
+      for (int su = 0; su < 2; su++) {
+        int u2 = adj[2 * u1 + su];
+        double cut_u = distances(u1, u2);
+
+        for (int sv = 0; sv < 2; sv++) {
+          int v2 = adj[2 * v1 + sv];
+          double gain = join + distances(u2, v2) - cut_u - distances(v1, v2);
+
+          if (gain < best) {
+            best = gain;
+            best_u1 = u1, best_u2 = u2, best_v1 = v1, best_v2 = v2;
+          }
+        }
+      }
+    };
+
+    if (near) {
+      for (int u1 : ws.members) {
+        for (int i = 0; i < near->k(); i++) {
+          consider(u1, near->of(u1)[i]);
+        }
+      }
+    }
+    if (best_u1 == -1) {
+      for (int u1 : ws.members) {
+        for (int v1 = 0; v1 < n; v1++) {
+          consider(u1, v1);
+        }
+      }
+    }
+
+    relink(adj, best_u1, best_u2, best_v1);
+    relink(adj, best_u2, best_u1, best_v2);
+    relink(adj, best_v1, best_v2, best_u1);
+    relink(adj, best_v2, best_v1, best_u2);
+
+    int into = ws.subtour[best_v1];
+    for (int city : ws.members) {
+      ws.subtour[city] = into;
+    }
+    ws.subtour_size[into] += ws.subtour_size[smallest];
+    ws.subtour_size[smallest] = 0;
+  }
+
+  // open the tour at its longest edge
+  double longest = -1;
+  int cut_from = 0, cut_to = adj[0];
+
+  for (int city = 0; city < n; city++) {
+    for (int slot = 0; slot < 2; slot++) {
+      int other = adj[2 * city + slot];
+      double length = distances(city, other);
+
+      if (length > longest) {
+        longest = length;
+        cut_from = city;
+        cut_to = other;
+      }
+    }
+  }
+
+  for (int i = 0, prev = cut_from, at = cut_to; i < n; i++) {
+    int next = adj[2 * at] != prev ? adj[2 * at] : adj[2 * at + 1];
+    child[i] = at;
+    prev = at;
+    at = next;
+  }
+}
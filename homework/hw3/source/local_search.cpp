@@ -0,0 +1,238 @@
+#include "local_search.hpp"
+
+#include <utility>
+
+namespace {
+
+// gains below this are rounding noise and would only make the search cycle
+const double EPS = 1e-9;
+
+} // namespace
+
+local_search::local_search(const distance_table<double> &distances,
+                           const neighbor_lists &near)
+    : _distances(&distances), _near(&near), _n(distances.size()),
+      _tour(_n + 1), _pos(_n + 1), _queued(_n + 1, 0) {
+  _queue.reserve(2 * (_n + 1));
+}
+
+double local_search::improve(int *path, clock::time_point deadline) {
+  if (_n < 3 || clock::now() > deadline) {
+    return 0;
+  }
+
+  for (int i = 0; i < _n; i++) {
+    _tour[i] = path[i];
+    _pos[path[i]] = i;
+  }
+  _tour[_n] = _n;
+  _pos[_n] = _n;
+
+  double before = _distances->path_length(path, _n);
+
+  _queue.clear();
+  _head = 0;
+  for (int i = 0; i < _n; i++) {
+    push(path[i]);
+  }
+
+  for (int popped = 0; _head < _queue.size(); popped++) {
+    if (popped % 64 == 0 && clock::now() > deadline) {
+      break;
+    }
+
+    int t1 = _queue[_head++];
+    _queued[t1] = 0;
+
+    // an improving move queues t1 again
+    if (!try_two_opt(t1)) {
+      try_or_opt(t1);
+    }
+  }
+
+  for (size_t i = _head; i < _queue.size(); i++) {
+    _queued[_queue[i]] = 0;
+  }
+
+  for (int i = 0, city = succ(_n); i < _n; i++, city = succ(city)) {
+    path[i] = city;
+  }
+
+  return before - _distances->path_length(path, _n);
+}
+
+void local_search::push(int city) {
+  if (city == _n || _queued[city]) {
+    return;
+  }
+
+  // every city is queued at most once, so the live part stays below n
+  if (_head > size_t(_n)) {
+    _queue.erase(_queue.begin(), _queue.begin() + _head);
+    _head = 0;
+  }
+
+  _queued[city] = 1;
+  _queue.push_back(city);
+}
+
+// Reverses the tour from `from` forwards to `to`, or the rest of the tour
+// when that is shorter, which leaves the same cycle.
+void local_search::reverse(int from, int to) {
+  int size = _tour.size();
+  int i = _pos[from], j = _pos[to];
+  int length = (j - i + size) % size + 1;
+
+  if (2 * length > size) {
+    std::swap(i, j);
+    i = i + 1 == size ? 0 : i + 1;
+    j = j == 0 ? size - 1 : j - 1;
+    length = size - length;
+  }
+
+  for (int k = 0; k < length / 2; k++) {
+    std::swap(_tour[i], _tour[j]);
+    _pos[_tour[i]] = i;
+    _pos[_tour[j]] = j;
+    i = i + 1 == size ? 0 : i + 1;
+    j = j == 0 ? size - 1 : j - 1;
+  }
+}
+
+// Replaces the tour edges a-b and c-d, met in the same direction, with a-c
+// and b-d.
+void local_search::exchange(int a, int b, int c, int /* d */) {
+  if (succ(a) == b) {
+    reverse(b, c);
+  } else {
+    reverse(c, b);
+  }
+}
+
+bool local_search::try_two_opt(int t1) {
+  const int *near = _near->of(t1);
+
+  for (int forward = 1; forward >= 0; forward--) {
+    int t2 = forward ? succ(t1) : pred(t1);
+    double removed = cost(t1, t2);
+
+    // the extra city first: ending the path at t1
+    for (int i = -1; i < _near->k(); i++) {
+      int t3 = i < 0 ? _n : near[i];
+      double gain = removed - cost(t1, t3);
+
+      if (gain <= EPS) {
+        if (i < 0) {
+          continue;
+        }
+        break;
+      }
+
+      int t4 = forward ? succ(t3) : pred(t3);
+      if (t3 == t2 || t4 == t1) {
+        continue;
+      }
+
+      gain += cost(t3, t4) - cost(t2, t4);
+      if (gain <= EPS) {
+        continue;
+      }
+
+      if (forward) {
+        exchange(t1, t2, t3, t4);
+      } else {
+        exchange(t2, t1, t4, t3);
+      }
+      _moves++;
+
+      for (int city : {t1, t2, t3, t4}) {
+        push(city);
+      }
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Moves the segment of one to three cities starting at t1 between two
+// adjacent cities near one of its ends, either way round.
+bool local_search::try_or_opt(int t1) {
+  int size = _tour.size();
+  if (size < 8) {
+    return false;
+  }
+
+  int s1 = t1, s2 = t1;
+
+  for (int length = 1; length <= 3; length++) {
+    if (length > 1) {
+      s2 = succ(s2);
+      if (s2 == _n) {
+        break;
+      }
+    }
+
+    int p = pred(s1), nx = succ(s2);
+    double removed = cost(p, s1) + cost(s2, nx) - cost(p, nx);
+    if (removed <= EPS) {
+      continue;
+    }
+
+    auto inside = [&](int city) {
+      return (_pos[city] - _pos[s1] + size) % size < length;
+    };
+
+    for (int end : {s1, s2}) {
+      if (end == s2 && length == 1) {
+        break;
+      }
+
+      const int *near = _near->of(end);
+
+      for (int i = 0; i < _near->k(); i++) {
+        int c = near[i];
+        if (cost(end, c) >= removed) {
+          break;
+        }
+        if (inside(c)) {
+          continue;
+        }
+
+        for (int after = 1; after >= 0; after--) {
+          // x -> y is the edge the segment goes into, `end` next to c
+          int x = after ? c : pred(c), y = after ? succ(c) : c;
+          if (inside(x) || inside(y) || y == p) {
+            continue;
+          }
+
+          bool in_order = (end == s1) == after;
+          double added = in_order ? cost(x, s1) + cost(s2, y)
+                                  : cost(x, s2) + cost(s1, y);
+          added -= cost(x, y);
+
+          if (removed - added <= EPS) {
+            continue;
+          }
+
+          // p s1..s2 nx .. x y  ->  p x .. nx s2..s1 y  ->  p nx .. x s2..s1 y
+          exchange(p, s1, x, y);
+          if (x != nx) {
+            exchange(p, x, nx, s2);
+          }
+          if (in_order) {
+            exchange(x, s2, s1, y);
+          }
+          _moves++;
+
+          for (int city : {p, nx, s1, s2, x, y}) {
+            push(city);
+          }
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
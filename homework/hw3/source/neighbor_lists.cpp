@@ -0,0 +1,100 @@
+#include "neighbor_lists.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+neighbor_lists::neighbor_lists(const std::vector<double> &xs,
+                               const std::vector<double> &ys, int k)
+    : _n(xs.size()), _k(std::max(0, std::min(k, int(xs.size()) - 1))),
+      _near(size_t(_n) * _k) {
+  if (!_k) {
+    return;
+  }
+
+  double min_x = *std::min_element(xs.begin(), xs.end());
+  double max_x = *std::max_element(xs.begin(), xs.end());
+  double min_y = *std::min_element(ys.begin(), ys.end());
+  double max_y = *std::max_element(ys.begin(), ys.end());
+
+  int side = std::max(1, int(std::sqrt(_n / 2.0)));
+  double cell = std::max(max_x - min_x, max_y - min_y) / side;
+  if (cell <= 0) {
+    cell = 1;
+  }
+
+  auto cell_of = [&](double value, double low) {
+    return std::min(side - 1, int((value - low) / cell));
+  };
+
+  // cities bucketed by cell, cell c holding members[first[c]..first[c + 1])
+  std::vector<int> first(side * side + 1, 0), members(_n);
+  for (int city = 0; city < _n; city++) {
+    first[cell_of(ys[city], min_y) * side + cell_of(xs[city], min_x) + 1]++;
+  }
+  for (int c = 0; c < side * side; c++) {
+    first[c + 1] += first[c];
+  }
+
+  std::vector<int> fill(first.begin(), first.end() - 1);
+  for (int city = 0; city < _n; city++) {
+    members[fill[cell_of(ys[city], min_y) * side + cell_of(xs[city], min_x)]++] =
+        city;
+  }
+
+  // the best `_k` so far as (squared distance, city), sorted
+  std::vector<std::pair<double, int>> best;
+
+  for (int city = 0; city < _n; city++) {
+    int cx = cell_of(xs[city], min_x), cy = cell_of(ys[city], min_y);
+    best.clear();
+
+    auto consider = [&](int gx, int gy) {
+      if (gx < 0 || gy < 0 || gx >= side || gy >= side) {
+        return;
+      }
+
+      int c = gy * side + gx;
+      for (int i = first[c]; i < first[c + 1]; i++) {
+        int other = members[i];
+        if (other == city) {
+          continue;
+        }
+
+        double dx = xs[other] - xs[city], dy = ys[other] - ys[city];
+        std::pair<double, int> entry = {dx * dx + dy * dy, other};
+
+        if (int(best.size()) == _k) {
+          if (!(entry < best.back())) {
+            continue;
+          }
+          best.pop_back();
+        }
+        best.insert(std::upper_bound(best.begin(), best.end(), entry), entry);
+      }
+    };
+
+    // every city past ring r is more than r cells away
+    for (int r = 0; r < side; r++) {
+      if (!r) {
+        consider(cx, cy);
+      } else {
+        for (int d = -r; d <= r; d++) {
+          consider(cx + d, cy - r);
+          consider(cx + d, cy + r);
+        }
+        for (int d = -r + 1; d < r; d++) {
+          consider(cx - r, cy + d);
+          consider(cx + r, cy + d);
+        }
+      }
+
+      if (int(best.size()) == _k && best.back().first <= r * cell * r * cell) {
+        break;
+      }
+    }
+
+    for (int i = 0; i < _k; i++) {
+      _near[size_t(city) * _k + i] = best[i].second;
+    }
+  }
+}
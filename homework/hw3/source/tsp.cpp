@@ -1,18 +1,30 @@
 #include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <math.h>
+#include <numeric>
 #include <queue>
 #include <random>
 #include <set>
 #include <vector>
 
+#include "allocation_counter.hpp"
+#include "crossover.hpp"
+#include "distance_table.hpp"
+#include "genome_arena.hpp"
+#include "local_search.hpp"
+#include "neighbor_lists.hpp"
+#include "thread_pool.hpp"
+
 template <typename T> using vec = std::vector<T>;
 
 template <typename T>
-void print(vec<T> v, bool nl = false, std::ostream &os = std::cout) {
+void print(const vec<T> &v, bool nl = false, std::ostream &os = std::cout) {
   for (auto t : v) {
     os << t;
     if (nl) {
@@ -70,9 +82,22 @@ struct genome {
   };
 };
 
+struct tsp_options {
+  unsigned seed = std::random_device{}();
+  int threads = 1;
+  int generation_size = 120;
+  crossover_kind crossover = crossover_kind::ox;
+  // milliseconds of 2-opt / Or-opt per generation, 0 leaves offspring as
+  // they are
+  double search_ms = 0;
+  int neighbors = 8;
+  // stop once the best path is this short, 0 runs every generation
+  double target = 0;
+};
+
 class GeneticTSP {
 private:
-  std::mt19937 mt = std::mt19937(std::random_device{}());
+  std::mt19937 mt;
   const double XY_MAX = 2000;
   const double XY_MIN = -2000;
   const double MUTATION_RATE = 0.8;
@@ -80,135 +105,192 @@ private:
   const int MAX_GENERATIONS = 1500;
   const int GENERATION_SIZE = 120;
   const int TOURNAMENT_SIZE = 40;
+  crossover_kind _crossover = crossover_kind::ox;
+  double _search_ms = 0;
+  int _neighbors = 8;
+  double _target = 0;
+
+  // offspring are made by `_pool`; worker w draws from `_streams[w]` and
+  // always makes the same slots, so a seed and a thread count fix the run
+  std::unique_ptr<thread_pool> _pool;
+  vec<std::mt19937> _streams;
+  vec<crossover_workspace> _workspaces;
+  vec<local_search> _searches;
+  // per worker, a permutation of population ranks drawn from by tournaments
+  vec<vec<int>> _tournaments;
+
+  // The population lives in _arenas[_current], ranked best first by
+  // _ranked[0..GENERATION_SIZE); the next generation is written into the
+  // other arena, and the two swap roles.
+  genome_arena _arenas[2];
+  int _current = 0;
+  vec<int> _ranked;
+  vec<int> _order;
 
   vec<town> _towns;
-  vec<vec<double>> _distances;
+  distance_table<double> _distances;
+  neighbor_lists _near;
+  long long _evaluations = 0;
 
-  std::pair<int, int> compute_bounds(int n) {
+  std::pair<int, int> compute_bounds(int n, std::mt19937 &rng) {
     std::uniform_int_distribution<int> urd_int(0, n - 1);
-    int lower = urd_int(mt);
+    int lower = urd_int(rng);
     urd_int = std::uniform_int_distribution<int>(lower, n);
-    int upper = urd_int(mt);
+    int upper = urd_int(rng);
 
     return {lower, upper};
   }
 
-  template <typename T> vec<T> top_k(vec<T> v, int k) {
-    sort(v.begin(), v.end());
-    return vec<T>(v.begin(), v.begin() + std::min(k, (int)v.size()));
+  double total_distance(const int *path) {
+    return _distances.path_length(path, _towns.size());
   }
 
-  double distance(double x1, double y1, double x2, double y2) {
-    return sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2));
-  }
-
-  double total_distance(genome g) {
-    double sum = 0;
-    for (size_t i = 1; i < g.path.size(); i++) {
-      sum += distance(_towns[g.path[i]].x, _towns[g.path[i]].y,
-                      _towns[g.path[i - 1]].x, _towns[g.path[i - 1]].y);
+  void initialize(genome_arena &arena, int gen_size) {
+    int n = _towns.size();
+    for (int i = 0; i < gen_size; i++) {
+      int *path = arena.path(i);
+      std::iota(path, path + n, 0);
+      std::shuffle(path, path + n, mt);
     }
-
-    return sum;
   }
 
-  vec<genome> initialize(int gen_size) {
-    vec<genome> gen(gen_size);
-    int n = _towns.size();
+  void evaluate(genome_arena &arena, int gen_size) {
     for (int i = 0; i < gen_size; i++) {
-      vec<int> perm(n);
-      std::iota(perm.begin(), perm.end(), 0);
-      std::shuffle(perm.begin(), perm.end(), mt);
-      gen[i] = {perm};
+      arena.fitness(i) = total_distance(arena.path(i));
     }
-    return gen;
+    _evaluations += gen_size;
   }
 
-  void evaluate(vec<genome> &generation) {
-    for (size_t i = 0; i < generation.size(); i++) {
-      generation[i].eval = total_distance(generation[i]);
-    }
+  // Ranks the first `count` genomes of `arena` into _order, the best
+  // GENERATION_SIZE of them sorted first.
+  void rank(const genome_arena &arena, int count) {
+    std::iota(_order.begin(), _order.begin() + count, 0);
+    std::partial_sort(
+        _order.begin(), _order.begin() + std::min(count, GENERATION_SIZE),
+        _order.begin() + count,
+        [&](int a, int b) { return arena.fitness(a) < arena.fitness(b); });
   }
 
-  vec<genome> select_parents(vec<genome> population) {
-    std::shuffle(population.begin(), population.end(), mt);
-    std::sort(population.begin(), population.begin() + TOURNAMENT_SIZE);
+  // The arena slots of the two best of TOURNAMENT_SIZE distinct genomes
+  // drawn at random from the population.
+  std::pair<int, int> select_parents(int worker, std::mt19937 &rng) {
+    const genome_arena &population = _arenas[_current];
+    vec<int> &ranks = _tournaments[worker];
+    int first = -1, second = -1;
+
+    for (int k = 0; k < TOURNAMENT_SIZE; k++) {
+      std::uniform_int_distribution<int> urd_rank(k, GENERATION_SIZE - 1);
+      std::swap(ranks[k], ranks[urd_rank(rng)]);
+
+      int slot = _ranked[ranks[k]];
+      if (first == -1 || population.fitness(slot) < population.fitness(first)) {
+        second = first;
+        first = slot;
+      } else if (second == -1 ||
+                 population.fitness(slot) < population.fitness(second)) {
+        second = slot;
+      }
+    }
 
-    return vec<genome>(population.begin(), population.begin() + 2);
+    return {first, second};
   }
 
-  vec<genome> reproduction(vec<genome> &parents) {
-
-    genome p1 = parents[0];
-    genome p2 = parents[1];
+  // Writes both children of p1 and p2 into c1 and c2.
+  void reproduction(const int *p1, const int *p2, int *c1, int *c2,
+                    int worker) {
+    std::mt19937 &rng = _streams[worker];
+    crossover_workspace &ws = _workspaces[worker];
     int n = _towns.size();
 
-    vec<genome> children = {{vec<int>(p1.path.begin(), p1.path.end())},
-                            {vec<int>(p2.path.begin(), p2.path.end())}};
-
-    std::pair<int, int> bounds = compute_bounds(n - 1);
-
-    vec<int> section1(p1.path.begin() + bounds.first,
-                      p1.path.begin() + bounds.second + 1);
-    vec<int> section2(p2.path.begin() + bounds.first,
-                      p2.path.begin() + bounds.second + 1);
-
-    for (size_t i = 0; i < section1.size(); i++) {
-      auto it1 = std::find(children[0].path.begin(), children[0].path.end(),
-                           section2[i]);
-      children[0].path.erase(it1);
-
-      auto it2 = std::find(children[1].path.begin(), children[1].path.end(),
-                           section1[i]);
-      children[1].path.erase(it2);
+    if (_crossover == crossover_kind::eax) {
+      edge_assembly_crossover(p1, p2, c1, n, _distances, ws, rng, &_near);
+      edge_assembly_crossover(p2, p1, c2, n, _distances, ws, rng, &_near);
+      return;
     }
 
-    std::shuffle(section1.begin(), section1.end(), mt);
-    std::shuffle(section2.begin(), section2.end(), mt);
-
-    children[1].path.insert(children[1].path.end(), section1.begin(),
-                            section1.end());
-    children[0].path.insert(children[0].path.end(), section2.begin(),
-                            section2.end());
+    std::pair<int, int> bounds = compute_bounds(n - 1, rng);
+    auto cross = _crossover == crossover_kind::pmx ? partially_mapped_crossover
+                                                   : order_crossover;
 
-    return children;
+    cross(p1, p2, c1, n, bounds.first, bounds.second, ws);
+    cross(p2, p1, c2, n, bounds.first, bounds.second, ws);
   }
 
-  void mutate(vec<genome> &children) {
+  void mutate(int *path, std::mt19937 &rng) {
     std::uniform_real_distribution<double> urd_mutate =
         std::uniform_real_distribution<double>(0., 1.);
 
     int n = _towns.size();
 
-    for (auto &child : children) {
-      if (urd_mutate(mt) < MUTATION_RATE) {
-        std::pair<int, int> bounds = compute_bounds(n - 1);
+    if (urd_mutate(rng) < MUTATION_RATE) {
+      std::pair<int, int> bounds = compute_bounds(n - 1, rng);
 
-        std::swap(child.path[bounds.first], child.path[bounds.second]);
-      }
-    };
+      std::swap(path[bounds.first], path[bounds.second]);
+    }
   }
 
   void calculate_distances() {
-    _distances = vec<vec<double>>(_towns.size(), vec<double>(_towns.size(), 0));
+    vec<double> xs(_towns.size()), ys(_towns.size());
 
     for (size_t i = 0; i < _towns.size(); i++) {
-      for (size_t j = 0; j < i; j++) {
-        double dist =
-            distance(_towns[j].x, _towns[j].y, _towns[i].x, _towns[i].y);
-        _distances[i][j] = dist;
-        _distances[j][i] = dist;
-      }
+      xs[i] = _towns[i].x;
+      ys[i] = _towns[i].y;
+    }
+
+    _distances = distance_table<double>(xs, ys);
+    _near = neighbor_lists(xs, ys, _neighbors);
+  }
+
+  void configure(const tsp_options &options) {
+    mt.seed(options.seed);
+    _crossover = options.crossover;
+    _search_ms = options.search_ms;
+    _neighbors = options.neighbors;
+    _target = options.target;
+    _pool = std::make_unique<thread_pool>(options.threads);
+    _streams.resize(_pool->size());
+    _workspaces.resize(_pool->size());
+
+    for (int worker = 0; worker < _pool->size(); worker++) {
+      std::seed_seq seq{options.seed, unsigned(worker) + 1};
+      _streams[worker].seed(seq);
     }
   }
 
+  void prepare_workers() {
+    for (auto &ws : _workspaces) {
+      ws.resize(_towns.size());
+    }
+    // built in place: a copy would not keep the reserved queue
+    _searches.clear();
+    _searches.reserve(_pool->size());
+    for (int worker = 0; worker < _pool->size(); worker++) {
+      _searches.emplace_back(_distances, _near);
+    }
+    _tournaments.resize(_pool->size());
+  }
+
+  // the end of this generation's local search, if there is any
+  local_search::clock::time_point search_deadline() {
+    return local_search::clock::now() +
+           std::chrono::microseconds((long long)(_search_ms * 1000));
+  }
+
 public:
-  GeneticTSP(vec<town> towns) {
+  GeneticTSP(vec<town> towns, const tsp_options &options = {})
+      : GENERATION_SIZE(options.generation_size),
+        TOURNAMENT_SIZE(std::min(40, options.generation_size)) {
+    configure(options);
     _towns = towns;
     calculate_distances();
+    prepare_workers();
   }
 
-  GeneticTSP(int n = 10) {
+  GeneticTSP(int n = 10, const tsp_options &options = {})
+      : GENERATION_SIZE(options.generation_size),
+        TOURNAMENT_SIZE(std::min(40, options.generation_size)) {
+    configure(options);
+
     std::uniform_real_distribution<double> urd_coord =
         std::uniform_real_distribution<double>(XY_MIN, XY_MAX);
 
@@ -220,67 +302,198 @@ public:
 
     _towns = towns;
     calculate_distances();
+    prepare_workers();
   }
 
   genome solve() {
+    auto start = std::chrono::steady_clock::now();
+    _evaluations = 0;
+
     int elitism_rate_dynamic = ELITISM_RATE;
     const int ELITISM_OFFSET = elitism_rate_dynamic * GENERATION_SIZE;
 
-    vec<genome> population = initialize(GENERATION_SIZE);
-    evaluate(population);
+    // pair j of a generation fills slots ELITISM_OFFSET + 2j and + 2j + 1
+    // of the next arena; every worker makes a fixed range of pairs
+    const int pairs = GENERATION_SIZE - ELITISM_OFFSET;
+    const int slots = ELITISM_OFFSET + 2 * pairs;
+    const int n = _towns.size();
+
+    for (auto &arena : _arenas) {
+      arena.reset(n, slots);
+    }
+    _current = 0;
+    _ranked.assign(slots, 0);
+    _order.assign(slots, 0);
+    for (auto &ranks : _tournaments) {
+      ranks.resize(GENERATION_SIZE);
+      std::iota(ranks.begin(), ranks.end(), 0);
+    }
 
-    genome min = *std::min_element(population.begin(), population.end());
+    initialize(_arenas[_current], GENERATION_SIZE);
 
-    std::cout << "gen null: " << min << std::endl;
+    if (_search_ms > 0) {
+      auto deadline = search_deadline();
 
-    for (int i = 1; i < MAX_GENERATIONS; i++) {
+      _pool->run([&](int worker) {
+        const int workers = _pool->size();
 
-      vec<genome> new_population;
+        for (int j = GENERATION_SIZE * worker / workers;
+             j < GENERATION_SIZE * (worker + 1) / workers; j++) {
+          _searches[worker].improve(_arenas[_current].path(j), deadline);
+        }
+      });
+    }
+    evaluate(_arenas[_current], GENERATION_SIZE);
+    rank(_arenas[_current], GENERATION_SIZE);
+    std::swap(_ranked, _order);
+
+    genome min;
+    auto keep_best = [&]() {
+      const genome_arena &population = _arenas[_current];
+      int best = _ranked[0];
+
+      if (population.fitness(best) < min.eval) {
+        min.path.assign(population.path(best), population.path(best) + n);
+        min.eval = population.fitness(best);
+      }
+    };
+    keep_best();
+
+    std::cout << "gen null: " << min << std::endl;
 
-      if (ELITISM_OFFSET) {
-        new_population = top_k(population, ELITISM_OFFSET);
+    int target_generation = -1;
+    double target_seconds = 0;
+
+    // the first generation whose best path is within rounding of the target
+    auto check_target = [&](int generation) {
+      if (_target > 0 && target_generation == -1 &&
+          min.eval <= _target * (1 + 1e-12)) {
+        target_generation = generation;
+        target_seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
       }
+    };
+    check_target(0);
+
+    // built once: a std::function holding this many references would
+    // allocate every generation
+    local_search::clock::time_point deadline;
+    const std::function<void(int)> breed = [&](int worker) {
+      std::mt19937 &rng = _streams[worker];
+      const genome_arena &population = _arenas[_current];
+      genome_arena &next = _arenas[1 - _current];
+      const int workers = _pool->size();
+
+      for (int j = pairs * worker / workers;
+           j < pairs * (worker + 1) / workers; j++) {
+        std::pair<int, int> parents = select_parents(worker, rng);
+        int s1 = ELITISM_OFFSET + 2 * j, s2 = s1 + 1;
+        int *c1 = next.path(s1), *c2 = next.path(s2);
+
+        reproduction(population.path(parents.first),
+                     population.path(parents.second), c1, c2, worker);
+        mutate(c1, rng);
+        mutate(c2, rng);
+
+        if (_search_ms > 0) {
+          _searches[worker].improve(c1, deadline);
+          _searches[worker].improve(c2, deadline);
+        }
+
+        next.fitness(s1) = total_distance(c1);
+        next.fitness(s2) = total_distance(c2);
+      }
+    };
 
-      for (int j = ELITISM_OFFSET; j < GENERATION_SIZE; j++) {
-        vec<genome> parents = select_parents(population);
-        vec<genome> children = reproduction(parents);
+    long long allocations_before = 0;
+    int counted_generations = 0;
 
-        mutate(children);
-        evaluate(children);
+    for (int i = 1; i < MAX_GENERATIONS && target_generation == -1; i++) {
+      // the first generation may still grow scratch buffers
+      if (i == 2) {
+        allocations_before = heap_allocations();
+      }
+      counted_generations += i >= 2;
+
+      const genome_arena &population = _arenas[_current];
+      genome_arena &next = _arenas[1 - _current];
 
-        new_population.insert(new_population.end(), children.begin(),
-                              children.end());
+      for (int e = 0; e < ELITISM_OFFSET; e++) {
+        next.copy(e, population, _ranked[e]);
       }
 
-      vec<genome> topk = top_k(new_population, GENERATION_SIZE);
+      deadline = search_deadline();
+      _pool->run(breed);
+      _evaluations += 2 * pairs;
+
+      rank(next, slots);
 
       // covergence
-      if (population == topk) {
+      bool same = true;
+      for (int k = 0; k < GENERATION_SIZE && same; k++) {
+        same = next.fitness(_order[k]) == population.fitness(_ranked[k]);
+      }
+      if (same) {
         break;
       }
 
-      population = topk;
+      std::swap(_ranked, _order);
+      _current = 1 - _current;
 
-      if (population[0] >= min) {
+      if (_arenas[_current].fitness(_ranked[0]) >= min.eval) {
         elitism_rate_dynamic /= 2;
       } else {
         elitism_rate_dynamic = ELITISM_RATE;
       }
 
-      min = std::min(min, population[0]);
+      keep_best();
+      check_target(i);
 
       if (i % (MAX_GENERATIONS / 4) == 0) {
         std::cout << "gen " << i << ": " << min << std::endl;
       }
     }
 
+    long long generation_allocations = heap_allocations() - allocations_before;
+
     std::cout << "gen last: " << min << std::endl;
 
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    std::cout << "evaluations: " << _evaluations << " ("
+              << _evaluations / seconds << "/s)" << std::endl;
+    // only counted in the check build, see allocation_counter.hpp
+    if (counted_generations && allocations_before >= 0) {
+      std::cout << "heap allocations in gens 2.." << counted_generations + 1
+                << ": " << generation_allocations << std::endl;
+    }
+
+    if (_search_ms > 0) {
+      long long moves = 0;
+      for (const auto &search : _searches) {
+        moves += search.moves();
+      }
+      std::cout << "local search moves: " << moves << std::endl;
+    }
+
+    if (_target > 0) {
+      std::cout << "gap to target: " << (min.eval / _target - 1) * 100 << "%"
+                << std::endl;
+      if (target_generation != -1) {
+        std::cout << "target reached at gen " << target_generation
+                  << " after " << target_seconds << "s" << std::endl;
+      } else {
+        std::cout << "target not reached" << std::endl;
+      }
+    }
+
     return min;
   }
 };
 
-void test_towns() {
+void test_towns(const tsp_options &options) {
 
   vec<town> towns;
 
@@ -309,7 +522,7 @@ void test_towns() {
 
   csv.close();
 
-  genome result = GeneticTSP(towns).solve();
+  genome result = GeneticTSP(towns, options).solve();
 
   std::cout << std::endl;
 
@@ -318,17 +531,127 @@ void test_towns() {
   }
 }
 
+// Evaluations per second of random tours of `n` random towns: the original
+// evaluation (the genome copied, every edge recomputed from the towns)
+// against distance_table with a double or float matrix and with on-the-fly
+// distances.
+void bench_evaluation(int n) {
+  std::mt19937 mt(n);
+  std::uniform_real_distribution<double> urd_coord(-2000, 2000);
+
+  vec<town> towns(n);
+  vec<double> xs(n), ys(n);
+  for (int i = 0; i < n; i++) {
+    towns[i] = {xs[i] = urd_coord(mt), ys[i] = urd_coord(mt)};
+  }
+
+  const int tours = 64;
+  vec<genome> genomes(tours);
+  for (auto &g : genomes) {
+    g.path.resize(n);
+    std::iota(g.path.begin(), g.path.end(), 0);
+    std::shuffle(g.path.begin(), g.path.end(), mt);
+  }
+
+  auto original = [&](genome g) {
+    double sum = 0;
+    for (size_t i = 1; i < g.path.size(); i++) {
+      const town &a = towns[g.path[i]], &b = towns[g.path[i - 1]];
+      sum += sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+    }
+    return sum;
+  };
+
+  distance_table<double> doubles(xs, ys, SIZE_MAX);
+  distance_table<float> floats(xs, ys, SIZE_MAX);
+  distance_table<double> on_the_fly(xs, ys, 0);
+  distance_table<double> automatic(xs, ys);
+
+  auto measure = [&](const char *name, auto evaluate) {
+    double checksum = 0;
+    long long evaluations = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0;
+
+    while (seconds < 0.5) {
+      for (const auto &g : genomes) {
+        checksum += evaluate(g);
+      }
+      evaluations += tours;
+      seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    }
+
+    std::cout << name << ": " << evaluations / seconds
+              << " evaluations/s (checksum " << checksum / evaluations << ")"
+              << std::endl;
+  };
+
+  std::cout << std::setprecision(6) << "n = " << n << std::endl;
+  measure("original", original);
+  measure("matrix double", [&](const genome &g) {
+    return doubles.path_length(g.path.data(), n);
+  });
+  measure("matrix float", [&](const genome &g) {
+    return floats.path_length(g.path.data(), n);
+  });
+  measure("on the fly", [&](const genome &g) {
+    return on_the_fly.path_length(g.path.data(), n);
+  });
+  std::cout << "default picks "
+            << (automatic.precomputed() ? "the matrix" : "on the fly")
+            << std::endl;
+}
+
+tsp_options parse_options(int argc, char *argv[], int first) {
+  tsp_options options;
+
+  for (int i = first; i < argc; i++) {
+    std::string arg = argv[i];
+
+    if (arg.rfind("--seed=", 0) == 0) {
+      options.seed = std::stoul(arg.substr(7));
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      // 0 uses every hardware thread
+      options.threads = std::stoi(arg.substr(10));
+      if (options.threads <= 0) {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+    } else if (arg.rfind("--population=", 0) == 0) {
+      options.generation_size = std::max(2, std::stoi(arg.substr(13)));
+    } else if (arg.rfind("--crossover=", 0) == 0) {
+      options.crossover = parse_crossover(arg.substr(12));
+    } else if (arg.rfind("--search-ms=", 0) == 0) {
+      options.search_ms = std::stod(arg.substr(12));
+    } else if (arg.rfind("--neighbors=", 0) == 0) {
+      options.neighbors = std::max(1, std::stoi(arg.substr(12)));
+    } else if (arg.rfind("--target=", 0) == 0) {
+      options.target = std::stod(arg.substr(9));
+    } else {
+      throw std::invalid_argument("Unknown option " + arg);
+    }
+  }
+
+  return options;
+}
+
 int main(int argc, char *argv[]) {
   std::cout << std::setprecision(16);
 
   try {
     if (argc > 1 && std::string(argv[1]) == "test") {
-      test_towns();
+      test_towns(parse_options(argc, argv, 2));
+    } else if (argc > 2 && std::string(argv[1]) == "bench") {
+      bench_evaluation(std::stoi(argv[2]));
+      return 0;
     } else {
+      tsp_options options = parse_options(argc, argv, 1);
+
       int n;
       std::cin >> n;
 
-      GeneticTSP tsp = GeneticTSP(n);
+      GeneticTSP tsp = GeneticTSP(n, options);
 
       tsp.solve();
     }